@@ -0,0 +1,101 @@
+#include "arena.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+/* Every allocation is rounded up to a multiple of this alignment */
+#define ARENA_ALIGNMENT sizeof(union { long l; double d; void *p; })
+
+
+/* The size of a block header, rounded up so that the memory after it is aligned */
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+
+
+void arena_init(Arena *arena)
+{
+	arena->blocks = NULL;
+}
+
+
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+	ArenaBlock *block = arena->blocks;
+	size_t block_size;
+	void *memory;
+	
+	size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+	
+	/* If there is no room in the current block, allocate a new one */
+	if (block == NULL || block->size - block->used < size)
+	{
+		block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+		block = (ArenaBlock *)memory_alloc(ARENA_HEADER_SIZE + block_size, MEMORY_ARENA);
+		
+		block->size = block_size;
+		block->used = 0;
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+	
+	memory = (char *)block + ARENA_HEADER_SIZE + block->used;
+	block->used += size;
+	
+	return memory;
+}
+
+
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+	char *copy = (char *)arena_alloc(arena, len + 1);
+	
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	
+	return copy;
+}
+
+
+
+char *arena_strdup(Arena *arena, const char *str)
+{
+	return arena_strndup(arena, str, strlen(str));
+}
+
+
+
+void arena_reset(Arena *arena)
+{
+	ArenaBlock *block = arena->blocks, *next_block, *kept = NULL;
+	
+	/* Free all the blocks, except one standard block that is kept for reuse */
+	while (block != NULL)
+	{
+		next_block = block->next;
+		if (kept == NULL && block->size == ARENA_BLOCK_SIZE)
+			kept = block;
+		else
+			memory_free(block);
+		block = next_block;
+	}
+	
+	if (kept != NULL)
+	{
+		kept->used = 0;
+		kept->next = NULL;
+	}
+	arena->blocks = kept;
+}
+
+
+
+void arena_free(Arena *arena)
+{
+	arena_reset(arena);
+	memory_free(arena->blocks);
+	arena->blocks = NULL;
+}
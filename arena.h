@@ -0,0 +1,92 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+
+#define ARENA_BLOCK_SIZE 65536 /* Size of a standard arena block, larger requests get a block of their own */
+
+
+/* A block of memory that allocations are carved from, its usable memory comes right after the header */
+typedef struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size;
+	size_t used;
+} ArenaBlock;
+
+
+/*
+ * A bump allocator: allocations are carved one after the other from large blocks and are never freed
+ * one by one. All of them are released together by arena_reset, which keeps the first block for reuse,
+ * so that assembling many small files does not call malloc at all after the first one.
+ */
+typedef struct {
+	ArenaBlock *blocks; /* The current block comes first */
+} Arena;
+
+
+
+/**
+ * Initializes an empty arena.
+ *
+ * @param arena The arena to initialize.
+ */
+void arena_init(Arena *arena);
+
+
+
+/**
+ * Allocates memory from the arena, aligned for any type.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the allocated memory, valid until the arena is reset.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+
+
+/**
+ * Copies the first `len` characters of a string into the arena and null-terminates the copy.
+ *
+ * @param arena The arena to allocate from.
+ * @param str The string to copy.
+ * @param len The number of characters to copy.
+ * @return The copy of the string.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+
+
+/**
+ * Copies a null-terminated string into the arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param str The string to copy.
+ * @return The copy of the string.
+ */
+char *arena_strdup(Arena *arena, const char *str);
+
+
+
+/**
+ * Releases all the allocations of the arena at once.
+ * The first standard block is kept for the next allocations, all other blocks are freed.
+ *
+ * @param arena The arena to reset.
+ */
+void arena_reset(Arena *arena);
+
+
+
+/**
+ * Frees all the memory of the arena, including the block kept by arena_reset.
+ *
+ * @param arena The arena to free.
+ */
+void arena_free(Arena *arena);
+
+
+
+#endif
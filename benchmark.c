@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200112L /* For getrusage */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "utils_and_checks.h"
+#include "context.h"
+#include "macro.h"
+#include "first_pass.h"
+#include "second_pass.h"
+#include "output.h"
+
+
+/*
+ * Measures the assembler on source files, phase by phase:
+ *
+ *     benchmark [-r repeats] file...
+ *
+ * Every file (given without the .as suffix, as to the assembler) is assembled `repeats` times, and the shortest wall time
+ * of each phase is kept. The results are written to the standard output as one JSON object per file (JSON Lines).
+ * The peak resident set size is of the whole process so far, so it is the peak of a single file only when each
+ * file is measured by its own run of the program (as `make bench` does).
+ */
+
+
+#define DEFAULT_REPEATS 5
+#define MAX_REPEATS 1000
+
+#define PHASE_MACRO 0
+#define PHASE_FIRST_PASS 1
+#define PHASE_SECOND_PASS 2
+#define NUM_PHASES 3
+
+static const char *phase_names[NUM_PHASES] = {"macro", "first_pass", "second_pass"};
+
+
+
+/* Assembles the file once, the same way as the assembler does, and sets the wall time of each phase.
+   Returns 1 if the file has errors, 0 otherwise. */
+static int run_once(char *name_file, AssemblyContext *ctx, double times[NUM_PHASES])
+{
+	int has_errors = 0;
+	double start = stats_clock(), end;
+
+	if (open_source_file(name_file, ctx) == ERROR || macro_analyze(ctx) == ERROR)
+		has_errors = 1;
+	end = stats_clock();
+	times[PHASE_MACRO] = end - start;
+
+	start = end;
+	if (first_pass_analyze(ctx))
+		has_errors = 1;
+	end = stats_clock();
+	times[PHASE_FIRST_PASS] = end - start;
+
+	start = end;
+	if (second_pass_analyze(name_file, ctx, has_errors) == ERROR)
+		has_errors = 1;
+	end = stats_clock();
+	times[PHASE_SECOND_PASS] = end - start;
+
+	return has_errors;
+}
+
+
+
+static void benchmark_file(char *name_file, int repeats, AssemblyContext *ctx)
+{
+	double best[NUM_PHASES], times[NUM_PHASES], total = 0;
+	int i, j, lines = 0, words = 0, has_errors = 0;
+	struct rusage usage;
+
+	for (i = 0; i < repeats; i++)
+	{
+		has_errors = run_once(name_file, ctx, times);
+
+		for (j = 0; j < NUM_PHASES; j++)
+			if (i == 0 || times[j] < best[j])
+				best[j] = times[j];
+
+		lines = ctx->source.num_lines;
+		words = ctx->code.count + ctx->data.count;
+
+		/* The messages of the file are printed once, aside from the results */
+		if (i == 0)
+			diagnostics_flush(&ctx->diagnostics, stderr);
+		context_reset(ctx);
+	}
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("{\"file\": \"%s\", \"lines\": %d, \"words\": %d, \"errors\": %s, \"repeats\": %d", name_file, lines, words, has_errors ? "true" : "false", repeats);
+	for (j = 0; j < NUM_PHASES; j++)
+	{
+		printf(", \"%s_seconds\": %.6f", phase_names[j], best[j]);
+		total += best[j];
+	}
+	printf(", \"total_seconds\": %.6f, \"lines_per_second\": %.0f, \"peak_rss_kb\": %ld}\n", total, total > 0 ? lines / total : 0, usage.ru_maxrss);
+	fflush(stdout);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	AssemblyContext ctx;
+	int i, repeats = DEFAULT_REPEATS;
+
+	output_init();
+	i = 1;
+	if (argc > 2 && strcmp(argv[1], "-r") == 0)
+	{
+		repeats = atoi(argv[2]);
+		i = 3;
+	}
+
+	if (i == argc || repeats < 1 || repeats > MAX_REPEATS)
+	{
+		fprintf(stderr, "Usage: benchmark [-r repeats (1 - %d)] file...\n", MAX_REPEATS);
+		return 1;
+	}
+
+	context_init(&ctx);
+
+	for (; i < argc; i++)
+		benchmark_file(argv[i], repeats, &ctx);
+
+	context_free(&ctx);
+
+	return 0;
+}
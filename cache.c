@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200112L /* For open, mkdir and getpid */
+
+#include "cache.h"
+#include "build_id.h"
+#include "output.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+#define CACHE_MAGIC "ASSEMBLER-CACHE"
+#define CACHE_VERSION ASSEMBLER_VERSION "-" ASSEMBLER_BUILD_ID /* The version of the entries, see cache.h */
+#define HEADER_SIZE (sizeof(CACHE_MAGIC) + sizeof(CACHE_VERSION) + 32) /* Room for the first line of an entry */
+#define CACHE_READ_SIZE 65536 /* The size of the blocks that an entry is read in */
+#define NUM_HASH_LANES 4 /* The key is made of 4 hashes of 32 bits */
+
+
+/* The sections that an entry may have, the extensions are the only files that are ever written from an entry */
+static const char *section_names[] = {".ob", ".bin", ".ent", ".ext", "messages"};
+#define NUM_SECTIONS 5
+#define SECTION_MESSAGES 4
+
+
+/* The starting values and the multipliers of the lanes of the hash, every lane is an FNV-1a hash with its own constants */
+static const uint32_t lane_seeds[NUM_HASH_LANES] = {2166136261U, 0x9E3779B9U, 0x85EBCA6BU, 0xC2B2AE35U};
+static const uint32_t lane_primes[NUM_HASH_LANES] = {16777619U, 0x01000197U, 0x0100019DU, 0x010001A9U};
+
+
+
+/* Mixes the bits of a lane, so that every bit of the key depends on every byte of the source */
+static uint32_t mix_lane(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+
+	return h;
+}
+
+
+
+/* Adds bytes to all the lanes of the hash */
+static void hash_bytes(uint32_t lanes[NUM_HASH_LANES], const char *data, size_t size)
+{
+	uint32_t h0 = lanes[0], h1 = lanes[1], h2 = lanes[2], h3 = lanes[3];
+	unsigned char byte;
+
+	while (size-- > 0)
+	{
+		byte = (unsigned char)*data++;
+		h0 = (h0 ^ byte) * lane_primes[0];
+		h1 = (h1 ^ byte) * lane_primes[1];
+		h2 = (h2 ^ byte) * lane_primes[2];
+		h3 = (h3 ^ byte) * lane_primes[3];
+	}
+
+	lanes[0] = h0;
+	lanes[1] = h1;
+	lanes[2] = h2;
+	lanes[3] = h3;
+}
+
+
+
+void cache_key(const SourceFile *source, int object_format, char key[CACHE_KEY_LENGTH + 1])
+{
+	const char *format = object_format == OBJECT_BINARY ? "binary" : "text";
+	uint32_t lanes[NUM_HASH_LANES];
+	char size[32];
+	int i;
+
+	for (i = 0; i < NUM_HASH_LANES; i++)
+		lanes[i] = lane_seeds[i];
+
+	/* The version, the format of the object file and the size come first, (each with its null terminator, to separate them) */
+	hash_bytes(lanes, CACHE_VERSION, sizeof(CACHE_VERSION));
+	hash_bytes(lanes, format, strlen(format) + 1);
+	sprintf(size, "%lu", (unsigned long)source->size);
+	hash_bytes(lanes, size, strlen(size) + 1);
+	hash_bytes(lanes, source->data, source->size);
+
+	/* Every lane is mixed with the next one, so that the lanes do not stay independent */
+	for (i = 0; i < NUM_HASH_LANES; i++)
+		sprintf(key + 8 * i, "%08lx", (unsigned long)mix_lane(lanes[i] ^ (lanes[(i + 1) % NUM_HASH_LANES] >> 7)));
+}
+
+
+
+/* Formats the first line of an entry: the magic word, the version and the size of the source. Returns its length */
+static int format_header(char header[HEADER_SIZE], size_t source_size)
+{
+	sprintf(header, "%s %s %lu\n", CACHE_MAGIC, CACHE_VERSION, (unsigned long)source_size);
+
+	return (int)strlen(header);
+}
+
+
+
+/* Returns the path of the entry of a key (allocated), with a suffix */
+static char *entry_path(const char *cache_dir, const char *key, const char *suffix)
+{
+	char *path = (char *)memory_alloc(strlen(cache_dir) + CACHE_KEY_LENGTH + strlen(suffix) + 2, MEMORY_FILE_NAMES);
+
+	sprintf(path, "%s/%s%s", cache_dir, key, suffix);
+
+	return path;
+}
+
+
+
+/* Reads a whole file into the buffer, returns ERROR if it cannot be read */
+static int read_entry(const char *path, TextBuffer *buffer)
+{
+	int fd, len;
+
+	buffer->length = 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return ERROR;
+
+	do
+	{
+		text_buffer_reserve(buffer, CACHE_READ_SIZE);
+		len = (int)read(fd, buffer->text + buffer->length, CACHE_READ_SIZE);
+		if (len > 0)
+			buffer->length += len;
+	}
+	while (len > 0);
+
+	close(fd);
+
+	return len == 0 ? SUCCESS : ERROR;
+}
+
+
+
+int cache_restore(const char *cache_dir, const char *key, size_t source_size, const char *name_file, TextBuffer *scratch, Diagnostics *diagnostics)
+{
+	char *path = entry_path(cache_dir, key, "");
+	const char *sections[NUM_SECTIONS], *data;
+	int lengths[NUM_SECTIONS];
+	char name[MAX_SECTION_NAME], header[HEADER_SIZE];
+	int i, j, length, result;
+
+	result = read_entry(path, scratch);
+	memory_free(path);
+	if (result == ERROR)
+		return CACHE_MISS;
+
+	/* The header must be the one of this version and of a source of this size */
+	i = format_header(header, source_size);
+	if (scratch->length < i || memcmp(scratch->text, header, i) != 0)
+		return CACHE_MISS;
+
+	for (j = 0; j < NUM_SECTIONS; j++)
+		sections[j] = NULL;
+
+	/* The sections, the whole entry is checked before anything is written */
+	while (i < scratch->length)
+	{
+		if (next_output_section(scratch->text, scratch->length, &i, name, &data, &length) == ERROR)
+			return CACHE_MISS;
+
+		for (j = 0; j < NUM_SECTIONS && strcmp(name, section_names[j]) != 0; j++)
+			;
+		if (j == NUM_SECTIONS || sections[j] != NULL)
+			return CACHE_MISS;
+
+		sections[j] = data;
+		lengths[j] = length;
+	}
+
+	/* An entry has an object file in one of the formats, and the messages */
+	if ((sections[0] == NULL && sections[1] == NULL) || sections[SECTION_MESSAGES] == NULL)
+		return CACHE_MISS;
+
+	if (lengths[SECTION_MESSAGES] > 0)
+		report(diagnostics, "%.*s", lengths[SECTION_MESSAGES], sections[SECTION_MESSAGES]);
+
+	for (j = 0; j < SECTION_MESSAGES; j++)
+		if (sections[j] != NULL && write_output_file(name_file, section_names[j], sections[j], lengths[j], diagnostics) == ERROR)
+			result = ERROR;
+
+	return result == ERROR ? CACHE_WRITE_FAILED : CACHE_RESTORED;
+}
+
+
+
+void cache_store(const char *cache_dir, const char *key, size_t source_size, const TextBuffer *sections)
+{
+	char *path = entry_path(cache_dir, key, "");
+	char suffix[64], header[HEADER_SIZE];
+	char *temp_path;
+	int fd, result;
+
+	/* The temporary file is unique to the process and the entry, since several files with the same source may be stored at the same time */
+	sprintf(suffix, ".%ld.%lx.tmp", (long)getpid(), (unsigned long)(size_t)sections);
+	temp_path = entry_path(cache_dir, key, suffix);
+
+	mkdir(cache_dir, 0777);
+
+	fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd != -1)
+	{
+		result = write_all(fd, header, format_header(header, source_size));
+		if (result == SUCCESS)
+			result = write_all(fd, sections->text, sections->length);
+
+		if (close(fd) != 0 || result == ERROR || rename(temp_path, path) != 0)
+			unlink(temp_path);
+	}
+
+	memory_free(temp_path);
+	memory_free(path);
+}
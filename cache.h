@@ -0,0 +1,82 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include "source_file.h"
+#include "text_buffer.h"
+#include "diagnostics.h"
+#include "object_file.h"
+
+
+/* The version of the assembler, which is a part of every cache key together with the build ID of the assembler
+   (ASSEMBLER_BUILD_ID, a hash of its sources that the makefile writes to build_id.h). Since any change to the sources
+   changes the build ID, the version only has to be changed when the format of the cache entries changes */
+#define ASSEMBLER_VERSION "1.1"
+
+#define CACHE_KEY_LENGTH 32 /* A key is a 128-bit hash, written in hexadecimal */
+
+/* The results of looking up a source in the cache */
+#define CACHE_MISS 0
+#define CACHE_RESTORED 1
+#define CACHE_WRITE_FAILED 2 /* The source was found, but one of its output files could not be written */
+
+
+/*
+ * The build cache (--cache directory) keeps the results of assembling sources without errors, keyed by a hash of
+ * the bytes of the source, the version and the build ID of the assembler, and the format of the object file. An entry is a file named
+ * by its key, which holds the size of the source, the output files (.ob or .bin, and .ent and .ext if there are any)
+ * and the messages of the source:
+ *
+ *     ASSEMBLER-CACHE <version>-<build ID> <size of the source>\n
+ *     <extension or "messages"> <length>\n<content>       (one section for every part, see output.h)
+ *
+ * When a source is found in the cache, it is not assembled: the output files are restored from the entry,
+ * and the messages are reported again.
+ */
+
+
+
+/**
+ * Computes the cache key of a source.
+ *
+ * @param source The source file.
+ * @param object_format The format of the object file, OBJECT_TEXT or OBJECT_BINARY.
+ * @param key The buffer for the key, the key is written with a null terminator.
+ */
+void cache_key(const SourceFile *source, int object_format, char key[CACHE_KEY_LENGTH + 1]);
+
+
+
+/**
+ * Looks up a source in the cache, and if it is there, restores its output files and reports its messages.
+ * Output files that already hold the content of the entry are not written again.
+ * An entry that cannot be read or is not valid is treated as missing, nothing is written in this case.
+ *
+ * @param cache_dir The cache directory.
+ * @param key The cache key of the source.
+ * @param source_size The size of the source, which is checked against the entry.
+ * @param name_file The base name of the output files (without extension).
+ * @param scratch A buffer that the entry is read into.
+ * @param diagnostics The buffer that the messages of the source are reported to.
+ * @return CACHE_RESTORED if the source was found and its output files were restored, CACHE_WRITE_FAILED if it was
+ *         found but an output file could not be written (the error is reported), or CACHE_MISS.
+ */
+int cache_restore(const char *cache_dir, const char *key, size_t source_size, const char *name_file, TextBuffer *scratch, Diagnostics *diagnostics);
+
+
+
+/**
+ * Writes a cache entry to the cache directory (which is created if it does not exist).
+ * The entry is written to a temporary file that is renamed to its key, so that an entry is always complete.
+ * The cache is only an optimization: if the entry cannot be written, nothing is reported.
+ *
+ * @param cache_dir The cache directory.
+ * @param key The cache key of the source.
+ * @param source_size The size of the source.
+ * @param sections The sections of the entry (see output.h): the output files of the source and its messages.
+ */
+void cache_store(const char *cache_dir, const char *key, size_t source_size, const TextBuffer *sections);
+
+
+
+#endif
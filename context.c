@@ -0,0 +1,102 @@
+#include "context.h"
+#include "first_pass.h"
+#include "memory.h"
+#include "object_file.h"
+#include "utils_and_checks.h"
+#include <stdlib.h>
+
+
+
+void context_init(AssemblyContext *ctx)
+{
+	arena_init(&ctx->arena);
+	source_init(&ctx->source);
+	macro_table_init(&ctx->macros, &ctx->arena);
+	text_buffer_init(&ctx->expanded);
+	symbol_table_init(&ctx->symbols, &ctx->arena, &ctx->diagnostics);
+	word_image_init(&ctx->code);
+	word_image_init(&ctx->data);
+	ctx->fixups = NULL;
+	ctx->num_fixups = 0;
+	ctx->fixups_capacity = 0;
+	diagnostics_init(&ctx->diagnostics);
+	text_buffer_init(&ctx->output);
+	stats_init(&ctx->stats);
+	ctx->object_format = OBJECT_TEXT;
+	ctx->record_outputs = 0;
+	text_buffer_init(&ctx->outputs);
+	ctx->bounded_memory = 0;
+	staging_init(&ctx->staged_code);
+	staging_init(&ctx->staged_data);
+	staging_init(&ctx->staged_externals);
+	ctx->free_fixups = 0;
+	ctx->first_pass_errors = 0;
+	
+	ctx->IC = MEMORY_START_ADDRESS;
+	ctx->DC = 0;
+	ctx->line_num_s = 0;
+	ctx->line_num_m = 0;
+}
+
+
+
+int context_open_staging(AssemblyContext *ctx, const char *name_file)
+{
+	ctx->bounded_memory = 1;
+	
+	if (staging_open(&ctx->staged_code, name_file, ".code.staged", &ctx->diagnostics) == ERROR ||
+		staging_open(&ctx->staged_data, name_file, ".data.staged", &ctx->diagnostics) == ERROR ||
+		staging_open(&ctx->staged_externals, name_file, ".ext.staged", &ctx->diagnostics) == ERROR)
+		return ERROR;
+	
+	return SUCCESS;
+}
+
+
+
+void context_reset(AssemblyContext *ctx)
+{
+	/* The data of all the lists and tables lives in the arena */
+	macro_table_free(&ctx->macros);
+	symbol_table_free(&ctx->symbols);
+	ctx->code.count = 0; /* The arrays themselves are kept for the next file */
+	ctx->data.count = 0;
+	ctx->num_fixups = 0;
+	
+	arena_reset(&ctx->arena);
+	
+	source_close(&ctx->source);
+	ctx->expanded.length = 0;
+	ctx->diagnostics.length = 0;
+	ctx->output.length = 0;
+	stats_init(&ctx->stats);
+	ctx->object_format = OBJECT_TEXT;
+	ctx->record_outputs = 0;
+	ctx->outputs.length = 0;
+	ctx->bounded_memory = 0;
+	staging_close(&ctx->staged_code);
+	staging_close(&ctx->staged_data);
+	staging_close(&ctx->staged_externals);
+	ctx->free_fixups = 0;
+	ctx->first_pass_errors = 0;
+	ctx->IC = MEMORY_START_ADDRESS;
+	ctx->DC = 0;
+	ctx->line_num_s = 0;
+	ctx->line_num_m = 0;
+}
+
+
+
+void context_free(AssemblyContext *ctx)
+{
+	context_reset(ctx);
+	arena_free(&ctx->arena);
+	source_free(&ctx->source);
+	text_buffer_free(&ctx->expanded);
+	diagnostics_free(&ctx->diagnostics);
+	text_buffer_free(&ctx->output);
+	text_buffer_free(&ctx->outputs);
+	memory_free(ctx->fixups);
+	word_image_free(&ctx->code);
+	word_image_free(&ctx->data);
+}
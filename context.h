@@ -0,0 +1,116 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "arena.h"
+#include "linked_list.h"
+#include "symbol_table.h"
+#include "macro_table.h"
+#include "diagnostics.h"
+#include "text_buffer.h"
+#include "source_file.h"
+#include "word_image.h"
+#include "stats.h"
+#include "staging.h"
+
+
+#define FIXUPS_INIT_CAPACITY 64 /* Initial size of the array of fixups */
+
+
+/* 
+ * A code word that waits for the address of a label, which is known only in the second pass
+ * (the operand of an instruction in direct addressing).
+ */
+typedef struct {
+	int word; /* The index of the word to complete in the code image, (its address is MEMORY_START_ADDRESS + word) */
+	int symbol; /* The index of the label in the symbol table, or -1 for a fixup that is free to be reused */
+	int line_num; /* The line of the instruction, (used for error messages). */
+	int next; /* With bounded memory: the index + 1 of the next fixup that waits for the same label, or of the next free fixup, 0 if none.
+	             In the second pass, the completed word */
+} Fixup;
+
+
+/* With bounded memory, a word that refers to a label that was already external when the word was encoded */
+typedef struct {
+	int address; /* The address of the word */
+	int symbol; /* The index of the label in the symbol table */
+} StagedExtern;
+
+
+/* 
+ * The state of assembling one source file.
+ * All the nodes and strings of the file (tokens, macros, symbol names and extern references)
+ * are allocated from the arena of the context, and are released together by context_reset.
+ * Nothing is shared between contexts, so different files can be assembled at the same time, each with its own context.
+ */
+typedef struct {
+	Arena arena;
+	SourceFile source; /* The source file (with suffix s) mapped into memory, macro contents point into it */
+	MacroTable macros;
+	TextBuffer expanded; /* The source after the macros are spread, (the content of the file with suffix m) */
+	SymbolTable symbols;
+	WordImage code; /* The instruction words, the word at index i is at address MEMORY_START_ADDRESS + i */
+	WordImage data; /* The data words, the word at index i is at address i of the data section, which starts at the final IC */
+	Fixup *fixups; /* The words that wait for label addresses, in the order of the instructions */
+	int num_fixups;
+	int fixups_capacity;
+	int IC; /* Instruction Counter, the address of the next instruction word (starts at MEMORY_START_ADDRESS) */
+	int DC; /* Data Counter, the address of the next data word relative to the data section */
+	int line_num_s; /* Line number in the file with suffix s, (used for error messages). */
+	int line_num_m; /* Line number in the file with suffix m, (used for error messages). */
+	Diagnostics diagnostics; /* The error and warning messages of the file */
+	TextBuffer output; /* The output file that is being formatted, kept so that its memory is reused from file to file */
+	AssemblyStats stats; /* The stage times and the counters of the file, (printed with --stats) */
+	int object_format; /* The format of the object file, OBJECT_TEXT or OBJECT_BINARY (see object_file.h) */
+	int record_outputs; /* 1 if the output files of the file are also recorded in outputs, for the build cache or for the streams */
+	TextBuffer outputs; /* The recorded output files, as sections (see output.h) */
+	int bounded_memory; /* 1 if the words are staged in files as they are encoded instead of being kept in the images (--bounded-memory) */
+	StagingFile staged_code; /* With bounded memory: the lines of the instruction words, as in the object file */
+	StagingFile staged_data; /* With bounded memory: the data words, 2 bytes each */
+	StagingFile staged_externals; /* With bounded memory: the StagedExtern records, in the order of the words */
+	int free_fixups; /* With bounded memory: the index + 1 of the first free fixup, 0 if none */
+	int first_pass_errors; /* With bounded memory: 1 if the first pass found errors in a part of the expanded source it was handed */
+} AssemblyContext;
+
+
+
+/**
+ * Initializes an empty assembly context.
+ *
+ * @param ctx The context to initialize.
+ */
+void context_init(AssemblyContext *ctx);
+
+
+
+/**
+ * Switches the context to the assembly with bounded memory, and creates the staging files of the words
+ * next to the output files. The staging files are removed when the context is reset.
+ *
+ * @param ctx An empty context (new or reset).
+ * @param name_file The name of the source file (without the .as suffix).
+ * @return SUCCESS if the staging files were created, ERROR otherwise (the error is reported).
+ */
+int context_open_staging(AssemblyContext *ctx, const char *name_file);
+
+
+
+/**
+ * Releases everything that was allocated while assembling a file, so that the context can be used for the next file.
+ * The counters and line numbers are set back to their initial values, and any messages left in the buffer are dropped.
+ *
+ * @param ctx The context to reset.
+ */
+void context_reset(AssemblyContext *ctx);
+
+
+
+/**
+ * Frees all the memory held by the context.
+ *
+ * @param ctx The context to free.
+ */
+void context_free(AssemblyContext *ctx);
+
+
+
+#endif
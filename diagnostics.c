@@ -0,0 +1,68 @@
+#define _POSIX_C_SOURCE 200112L /* For vsnprintf */
+
+#include "diagnostics.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+
+
+void diagnostics_init(Diagnostics *diagnostics)
+{
+	diagnostics->text = NULL;
+	diagnostics->length = 0;
+	diagnostics->capacity = 0;
+}
+
+
+
+void report(Diagnostics *diagnostics, const char *format, ...)
+{
+	va_list args;
+	int needed;
+	
+	/* Find the length of the message */
+	va_start(args, format);
+	needed = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	
+	if (needed < 0)
+		return;
+	
+	/* Grow the buffer to fit the message and its null terminator */
+	if (diagnostics->length + needed + 1 > diagnostics->capacity)
+	{
+		int capacity = diagnostics->capacity ? diagnostics->capacity : DIAGNOSTICS_INIT_CAPACITY;
+		
+		while (diagnostics->length + needed + 1 > capacity)
+			capacity *= 2;
+		
+		diagnostics->text = (char *)memory_realloc(diagnostics->text, capacity, MEMORY_DIAGNOSTICS);
+		diagnostics->capacity = capacity;
+	}
+	
+	va_start(args, format);
+	vsnprintf(diagnostics->text + diagnostics->length, needed + 1, format, args);
+	va_end(args);
+	
+	diagnostics->length += needed;
+}
+
+
+
+void diagnostics_flush(Diagnostics *diagnostics, FILE *stream)
+{
+	if (diagnostics->length > 0)
+		fwrite(diagnostics->text, 1, diagnostics->length, stream);
+	
+	diagnostics->length = 0;
+}
+
+
+
+void diagnostics_free(Diagnostics *diagnostics)
+{
+	memory_free(diagnostics->text);
+	diagnostics_init(diagnostics);
+}
@@ -0,0 +1,62 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdio.h>
+
+
+#define DIAGNOSTICS_INIT_CAPACITY 256 /* Initial size of the message buffer */
+
+
+/*
+ * The error and warning messages of one source file.
+ * The messages are collected in a buffer instead of being printed right away, so that files that are
+ * assembled at the same time do not mix their messages, and the messages are printed in the order of the files.
+ */
+typedef struct {
+	char *text;
+	int length;
+	int capacity;
+} Diagnostics;
+
+
+
+/**
+ * Initializes an empty message buffer.
+ *
+ * @param diagnostics The buffer to initialize.
+ */
+void diagnostics_init(Diagnostics *diagnostics);
+
+
+
+/**
+ * Adds a message to the buffer, formatted as in printf.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param diagnostics The buffer to add the message to.
+ * @param format The printf format of the message.
+ */
+void report(Diagnostics *diagnostics, const char *format, ...);
+
+
+
+/**
+ * Writes all the messages of the buffer to a stream and empties the buffer.
+ *
+ * @param diagnostics The buffer to write.
+ * @param stream The stream to write the messages to.
+ */
+void diagnostics_flush(Diagnostics *diagnostics, FILE *stream);
+
+
+
+/**
+ * Frees the memory held by the buffer.
+ *
+ * @param diagnostics The buffer to free.
+ */
+void diagnostics_free(Diagnostics *diagnostics);
+
+
+
+#endif
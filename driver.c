@@ -0,0 +1,591 @@
+#define _POSIX_C_SOURCE 200112L /* For the POSIX threads */
+
+#include "driver.h"
+#include "utils_and_checks.h"
+#include "macro.h"
+#include "first_pass.h"
+#include "second_pass.h"
+#include "memory.h"
+#include "cache.h"
+#include "output.h"
+#include "object_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+/* 
+ * The files of a worker, as a range of indexes in the list of files.
+ * The owner of the queue takes files from the front, so that the files are mostly finished in their order
+ * and their messages can be printed early, while other workers steal files from the back.
+ */
+typedef struct {
+	int front;
+	int back; /* One after the last file of the queue */
+	pthread_mutex_t lock;
+} FileQueue;
+
+
+typedef struct WorkerPool WorkerPool;
+
+
+typedef struct {
+	pthread_t thread;
+	int id;
+	FileQueue queue;
+	WorkerPool *pool;
+} Worker;
+
+
+/* The result of assembling one file, handed over from the worker to the thread that prints the messages */
+typedef struct {
+	Diagnostics diagnostics;
+	AssemblyStats stats;
+	int has_errors;
+	int done;
+} FileResult;
+
+
+struct WorkerPool {
+	char **files;
+	int num_files;
+	const AssemblerOptions *options;
+	FILE *out; /* The stream that the messages and the statistics are printed to */
+	Worker *workers;
+	int num_workers;
+	FileResult *results;
+	pthread_mutex_t results_lock;
+	pthread_cond_t result_ready; /* Signaled whenever a file is done */
+};
+
+
+
+int count_stream_sources(char *files[], int num_files)
+{
+	int i, count = 0;
+	
+	for (i = 0; i < num_files; i++)
+		if (strcmp(files[i], STREAM_NAME) == 0)
+			count++;
+	
+	return count;
+}
+
+
+
+/* Returns the value of an option that takes one (in the next argument), or NULL if it is missing (an error message is printed) */
+static char *option_value(int argc, char *argv[], int *i, const char *expected, FILE *out)
+{
+	if (*i + 1 == argc)
+	{
+		fprintf(out, "Error! The option %s expects %s\n", argv[*i], expected);
+		return NULL;
+	}
+	
+	return argv[++*i];
+}
+
+
+
+/* Reads a file descriptor number, returns ERROR if it is not valid */
+static int parse_fd(const char *str)
+{
+	char *end;
+	long num = strtol(str, &end, 10);
+	
+	if (*str == EOS || *end != EOS || num < 0 || num > MAX_FD)
+		return ERROR;
+	
+	return (int)num;
+}
+
+
+
+int parse_options(int argc, char *argv[], AssemblerOptions *options, FILE *out)
+{
+	int i, num_files = 0, *fd;
+	char *value;
+	
+	options->num_threads = 1;
+	options->keep_am = 0;
+	options->stats = STATS_NONE;
+	options->cache_dir = NULL;
+	options->server_path = NULL;
+	options->ent_fd = -1;
+	options->ext_fd = -1;
+	options->mux = 0;
+	options->object_format = OBJECT_TEXT;
+	options->bounded_memory = 0;
+	
+	
+	/* Separate the options from the names of the source files, the names are kept at the start of argv */
+	for (i = 0; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--keep-am") == 0)
+			options->keep_am = 1;
+		
+		else if (strcmp(argv[i], "--stats") == 0)
+			options->stats = STATS_TEXT;
+		
+		else if (strcmp(argv[i], "--stats=json") == 0)
+			options->stats = STATS_JSON;
+		
+		else if (strcmp(argv[i], "--object=text") == 0)
+			options->object_format = OBJECT_TEXT;
+		
+		else if (strcmp(argv[i], "--object=binary") == 0)
+			options->object_format = OBJECT_BINARY;
+		
+		else if (strcmp(argv[i], "--cache") == 0)
+		{
+			if ((options->cache_dir = option_value(argc, argv, &i, "a directory", out)) == NULL)
+				return ERROR;
+		}
+		
+		else if (strcmp(argv[i], "--server") == 0)
+		{
+			if ((options->server_path = option_value(argc, argv, &i, "a socket path", out)) == NULL)
+				return ERROR;
+		}
+		
+		else if (strcmp(argv[i], "--bounded-memory") == 0)
+			options->bounded_memory = 1;
+		
+		else if (strcmp(argv[i], "--mux") == 0)
+			options->mux = 1;
+		
+		else if (strcmp(argv[i], "--ent-fd") == 0 || strcmp(argv[i], "--ext-fd") == 0)
+		{
+			fd = strcmp(argv[i], "--ent-fd") == 0 ? &options->ent_fd : &options->ext_fd;
+			if ((value = option_value(argc, argv, &i, "a file descriptor", out)) == NULL)
+				return ERROR;
+			if ((*fd = parse_fd(value)) == ERROR)
+			{
+				fprintf(out, "Error! The option %s expects a file descriptor, not %s\n", argv[i - 1], value);
+				return ERROR;
+			}
+		}
+		
+		else if (strncmp(argv[i], "-j", 2) == 0)
+		{
+			/* The number of threads follows the option, either in the same argument (-j4) or in the next one (-j 4) */
+			if (argv[i][2] != EOS)
+				options->num_threads = parse_num_threads(argv[i] + 2);
+			else if (i + 1 < argc)
+				options->num_threads = parse_num_threads(argv[++i]);
+			else
+				options->num_threads = ERROR;
+			
+			if (options->num_threads == ERROR)
+			{
+				fprintf(out, "Error! The option -j expects a number of threads between 0 and %d (0 = all the processors)\n", MAX_THREADS);
+				return ERROR;
+			}
+		}
+		else
+			argv[num_files++] = argv[i];
+	}
+	
+	/* The standard input can be read only once */
+	if (count_stream_sources(argv, num_files) > 1)
+	{
+		fprintf(out, "Error! The standard input (%s) can be given only once\n", STREAM_NAME);
+		return ERROR;
+	}
+	
+	/* The staged words are written straight to a text object file next to the source, they are never held whole in memory */
+	if (options->bounded_memory && (options->keep_am || options->cache_dir != NULL || options->object_format == OBJECT_BINARY ||
+		count_stream_sources(argv, num_files) > 0))
+	{
+		fprintf(out, "Error! The option --bounded-memory cannot be used with --keep-am, --cache, --object=binary or the standard input (%s)\n", STREAM_NAME);
+		return ERROR;
+	}
+	
+	return num_files;
+}
+
+
+
+/* Copies the counters that the tables and images of the context already hold to its statistics */
+static void collect_counters(AssemblyContext *ctx)
+{
+	ctx->stats.files = 1;
+	ctx->stats.lines = ctx->source.num_lines;
+	ctx->stats.words = ctx->IC - MEMORY_START_ADDRESS + ctx->DC;
+	ctx->stats.symbols = ctx->symbols.count;
+	ctx->stats.macros = ctx->macros.count;
+	ctx->stats.fixups = ctx->num_fixups;
+	ctx->stats.symbol_lookups = ctx->symbols.lookups;
+}
+
+
+
+/* Writes the recorded output files of the source from the standard input to their streams: all of them as sections
+   to the standard output (--mux), or else the object file to the standard output and the entries and externals
+   to the descriptors that were given for them (--ent-fd, --ext-fd), if any */
+static int write_streams(AssemblyContext *ctx, const AssemblerOptions *options)
+{
+	char name[MAX_SECTION_NAME];
+	const char *data;
+	int i = 0, length, fd;
+	
+	if (options->mux)
+		return write_all(STDOUT_FILENO, ctx->outputs.text, ctx->outputs.length);
+	
+	while (i < ctx->outputs.length)
+	{
+		next_output_section(ctx->outputs.text, ctx->outputs.length, &i, name, &data, &length);
+		
+		if (strcmp(name, ".ob") == 0 || strcmp(name, ".bin") == 0)
+			fd = STDOUT_FILENO;
+		else if (strcmp(name, ".ent") == 0)
+			fd = options->ent_fd;
+		else
+			fd = options->ext_fd;
+		
+		if (fd >= 0 && write_all(fd, data, length) == ERROR)
+			return ERROR;
+	}
+	
+	return SUCCESS;
+}
+
+
+
+int assemble_file(char *name_file, AssemblyContext *ctx, const AssemblerOptions *options)
+{
+	char key[CACHE_KEY_LENGTH + 1];
+	int has_errors = 0, result, is_stream = strcmp(name_file, STREAM_NAME) == 0, use_cache;
+	double start;
+	
+	stats_file_start();
+	
+	start = stats_stage_start();
+	result = open_source_file(name_file, ctx);
+	stats_stage_end(&ctx->stats, STAGE_MACRO_ANALYZE, start);
+	
+	/* A file that cannot be opened is skipped, its error message was reported */
+	if (result == ERROR)
+	{
+		stats_file_end(&ctx->stats);
+		return ERROR;
+	}
+	
+	/* The output files of the source from the standard input have no names, they are recorded and then written to streams */
+	ctx->record_outputs = is_stream;
+	ctx->object_format = options->object_format;
+	
+	/* A source that was already assembled by this version is not assembled again, its output files are restored from the cache.
+	   The file with suffix m is not kept in the cache, so it is always assembled when the file is asked for */
+	use_cache = options->cache_dir != NULL && !options->keep_am && !is_stream;
+	if (use_cache)
+	{
+		start = stats_stage_start();
+		cache_key(&ctx->source, options->object_format, key);
+		result = cache_restore(options->cache_dir, key, ctx->source.size, name_file, &ctx->output, &ctx->diagnostics);
+		ctx->record_outputs = result == CACHE_MISS;
+		stats_stage_end(&ctx->stats, STAGE_BUILD_CACHE, start);
+		
+		if (result != CACHE_MISS)
+		{
+			collect_counters(ctx);
+			ctx->stats.cache_hits = 1;
+			stats_file_end(&ctx->stats);
+			return result == CACHE_RESTORED ? SUCCESS : ERROR;
+		}
+	}
+	
+	/* With bounded memory, the first pass runs on chunks of the expanded source while the macros are spread */
+	if (options->bounded_memory && context_open_staging(ctx, name_file) == ERROR)
+	{
+		stats_file_end(&ctx->stats);
+		return ERROR;
+	}
+	
+	start = stats_stage_start();
+	if (macro_analyze(ctx) == ERROR)
+		has_errors = 1;
+	stats_stage_end(&ctx->stats, STAGE_MACRO_ANALYZE, start);
+	
+	/* The first pass reads the expanded source from memory, the file with suffix m is only written on request
+	   (for the source from the standard input, only to the multiplexed stream) */
+	if (options->keep_am)
+	{
+		start = stats_stage_start();
+		if (create_am_file(name_file, ctx) == ERROR)
+			has_errors = 1;
+		if (is_stream && options->mux)
+			output_section(&ctx->outputs, ".am", ctx->expanded.text, ctx->expanded.length);
+		stats_stage_end(&ctx->stats, STAGE_CREATE_OTHER_FILES, start);
+	}
+	
+	start = stats_stage_start();
+	if (first_pass_analyze(ctx) || ctx->first_pass_errors)
+		has_errors = 1;
+	stats_stage_end(&ctx->stats, STAGE_FIRST_PASS_ANALYZE, start);
+	
+	if (second_pass_analyze(name_file, ctx, has_errors) == ERROR)
+		has_errors = 1;
+	
+	if (is_stream && !has_errors)
+	{
+		start = stats_stage_start();
+		if (write_streams(ctx, options) == ERROR)
+		{
+			report(&ctx->diagnostics, "Error! The output files cannot be written to their streams\n");
+			has_errors = 1;
+		}
+		stats_stage_end(&ctx->stats, STAGE_CREATE_OTHER_FILES, start);
+	}
+	
+	/* Only a source without errors is stored, with its output files (recorded by the second pass) and its warnings */
+	if (use_cache && !has_errors)
+	{
+		start = stats_stage_start();
+		output_section(&ctx->outputs, "messages", ctx->diagnostics.text, ctx->diagnostics.length);
+		cache_store(options->cache_dir, key, ctx->source.size, &ctx->outputs);
+		stats_stage_end(&ctx->stats, STAGE_BUILD_CACHE, start);
+	}
+	
+	collect_counters(ctx);
+	stats_file_end(&ctx->stats);
+	
+	if (has_errors)
+	{
+		report(&ctx->diagnostics, "Errors were detected and therefore no output files are generated, sorry:(\n");
+		return ERROR;
+	}
+	
+	return SUCCESS;
+}
+
+
+
+/* Prints the statistics of a file (if they were asked for), and adds them to the totals */
+static void print_file_stats(const char *name_file, const AssemblyStats *stats, AssemblyStats *total, const AssemblerOptions *options, FILE *out)
+{
+	stats_add(total, stats);
+	
+	if (options->stats != STATS_NONE)
+		stats_print(out, name_file, stats, options->stats);
+}
+
+
+
+/* Prints the totals of the statistics of all the files (if they were asked for) */
+static void print_total_stats(const AssemblyStats *total, const AssemblerOptions *options, FILE *out)
+{
+	if (options->stats != STATS_NONE)
+		stats_print(out, NULL, total, options->stats);
+}
+
+
+
+/* Takes the next file for the worker: from the front of its own queue, or else from the back of the queue of another worker.
+   Returns -1 when there are no files left in any queue (files are never added once the workers start). */
+static int take_file(Worker *worker)
+{
+	WorkerPool *pool = worker->pool;
+	FileQueue *queue = &worker->queue;
+	int i, file = -1;
+	
+	pthread_mutex_lock(&queue->lock);
+	if (queue->front < queue->back)
+		file = queue->front++;
+	pthread_mutex_unlock(&queue->lock);
+	
+	/* Steal from the other workers, starting with the next one so that the victims are spread */
+	for (i = 1; file == -1 && i < pool->num_workers; i++)
+	{
+		queue = &pool->workers[(worker->id + i) % pool->num_workers].queue;
+		
+		pthread_mutex_lock(&queue->lock);
+		if (queue->front < queue->back)
+			file = --queue->back;
+		pthread_mutex_unlock(&queue->lock);
+	}
+	
+	return file;
+}
+
+
+
+static void *worker_main(void *arg)
+{
+	Worker *worker = (Worker *)arg;
+	WorkerPool *pool = worker->pool;
+	AssemblyContext ctx;
+	MemoryAccount account;
+	int file, has_errors;
+	
+	/* The allocations of the worker are counted only for the statistics */
+	if (pool->options->stats != STATS_NONE)
+	{
+		memory_account_init(&account);
+		memory_use_account(&account);
+	}
+	context_init(&ctx);
+	
+	while ((file = take_file(worker)) != -1)
+	{
+		has_errors = assemble_file(pool->files[file], &ctx, pool->options) == ERROR;
+		
+		/* Hand the messages of the file over to the printing thread, the context starts a new buffer */
+		memory_disown(ctx.diagnostics.text);
+		pthread_mutex_lock(&pool->results_lock);
+		pool->results[file].diagnostics = ctx.diagnostics;
+		pool->results[file].stats = ctx.stats;
+		pool->results[file].has_errors = has_errors;
+		pool->results[file].done = 1;
+		pthread_cond_broadcast(&pool->result_ready);
+		pthread_mutex_unlock(&pool->results_lock);
+		
+		diagnostics_init(&ctx.diagnostics);
+		context_reset(&ctx);
+	}
+	
+	context_free(&ctx);
+	memory_use_account(NULL);
+	
+	return NULL;
+}
+
+
+
+static int assemble_files_parallel(char *files[], int num_files, int num_threads, const AssemblerOptions *options, FILE *out)
+{
+	WorkerPool pool;
+	AssemblyStats total;
+	int i, num_started = 0, num_errors = 0;
+	
+	pool.files = files;
+	pool.num_files = num_files;
+	pool.options = options;
+	pool.out = out;
+	pool.num_workers = num_threads;
+	pool.workers = (Worker *)memory_alloc(num_threads * sizeof(Worker), MEMORY_DRIVER);
+	pool.results = (FileResult *)memory_alloc(num_files * sizeof(FileResult), MEMORY_DRIVER);
+	
+	stats_init(&total);
+	pthread_mutex_init(&pool.results_lock, NULL);
+	pthread_cond_init(&pool.result_ready, NULL);
+	
+	for (i = 0; i < num_files; i++)
+	{
+		diagnostics_init(&pool.results[i].diagnostics);
+		pool.results[i].has_errors = 0;
+		pool.results[i].done = 0;
+	}
+	
+	/* Split the files into consecutive ranges, one for each worker */
+	for (i = 0; i < num_threads; i++)
+	{
+		pool.workers[i].id = i;
+		pool.workers[i].pool = &pool;
+		pool.workers[i].queue.front = (int)((long)num_files * i / num_threads);
+		pool.workers[i].queue.back = (int)((long)num_files * (i + 1) / num_threads);
+		pthread_mutex_init(&pool.workers[i].queue.lock, NULL);
+	}
+	
+	/* The files of a worker that could not be started are stolen by the others */
+	for (i = 0; i < num_threads; i++)
+	{
+		if (pthread_create(&pool.workers[i].thread, NULL, worker_main, &pool.workers[i]) != 0)
+			break;
+		num_started++;
+	}
+	
+	/* If no thread could be started at all, assemble all the files in this thread */
+	if (num_started == 0)
+		worker_main(&pool.workers[0]);
+	
+	/* Print the messages of the files in their order, as soon as each one is done */
+	for (i = 0; i < num_files; i++)
+	{
+		pthread_mutex_lock(&pool.results_lock);
+		while (!pool.results[i].done)
+			pthread_cond_wait(&pool.result_ready, &pool.results_lock);
+		pthread_mutex_unlock(&pool.results_lock);
+		
+		diagnostics_flush(&pool.results[i].diagnostics, out);
+		diagnostics_free(&pool.results[i].diagnostics);
+		print_file_stats(files[i], &pool.results[i].stats, &total, options, out);
+		
+		if (pool.results[i].has_errors)
+			num_errors++;
+	}
+	
+	print_total_stats(&total, options, out);
+	
+	for (i = 0; i < num_started; i++)
+		pthread_join(pool.workers[i].thread, NULL);
+	
+	for (i = 0; i < num_threads; i++)
+		pthread_mutex_destroy(&pool.workers[i].queue.lock);
+	pthread_mutex_destroy(&pool.results_lock);
+	pthread_cond_destroy(&pool.result_ready);
+	
+	memory_free(pool.workers);
+	memory_free(pool.results);
+	
+	return num_errors;
+}
+
+
+
+int assemble_files_with_context(char *files[], int num_files, const AssemblerOptions *options, AssemblyContext *ctx, FILE *out)
+{
+	AssemblyStats total;
+	int i, num_errors = 0;
+	
+	stats_init(&total);
+	
+	/* Iterate over each file, printing its messages once it is done */
+	for (i = 0; i < num_files; i++)
+	{
+		if (assemble_file(files[i], ctx, options) == ERROR)
+			num_errors++;
+		
+		diagnostics_flush(&ctx->diagnostics, out);
+		print_file_stats(files[i], &ctx->stats, &total, options, out);
+		
+		/* Release everything that was allocated for the file */
+		context_reset(ctx);
+	}
+	
+	print_total_stats(&total, options, out);
+	
+	return num_errors;
+}
+
+
+
+int assemble_files(char *files[], int num_files, const AssemblerOptions *options, FILE *out)
+{
+	AssemblyContext ctx;
+	MemoryAccount account;
+	int num_errors, num_threads = options->num_threads;
+	
+	if (num_threads > num_files)
+		num_threads = num_files;
+	
+	if (num_threads > 1)
+		return assemble_files_parallel(files, num_files, num_threads, options, out);
+	
+	/* The allocations are counted only for the statistics */
+	if (options->stats != STATS_NONE)
+	{
+		memory_account_init(&account);
+		memory_use_account(&account);
+	}
+	context_init(&ctx);
+	
+	num_errors = assemble_files_with_context(files, num_files, options, &ctx, out);
+	
+	context_free(&ctx);
+	memory_use_account(NULL);
+	
+	return num_errors;
+}
@@ -0,0 +1,113 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <stdio.h>
+#include "context.h"
+
+
+#define MAX_FD 65535 /* The largest file descriptor that can be given to --ent-fd and --ext-fd */
+
+
+/* The command line options of the assembler */
+typedef struct {
+	int num_threads; /* The number of worker threads (-j), between 1 and MAX_THREADS */
+	int keep_am; /* 1 to write the source after the macros are spread to a file with suffix m (--keep-am) */
+	const char *cache_dir; /* The build cache directory (--cache), or NULL */
+	int stats; /* STATS_NONE, or the format of the statistics printed after every file and for all the files (--stats, --stats=json) */
+	const char *server_path; /* The socket to serve requests on (--server), or NULL */
+	int ent_fd; /* The descriptor that the entries of the source from the standard input are written to (--ent-fd), or -1 */
+	int ext_fd; /* The descriptor that the externals of the source from the standard input are written to (--ext-fd), or -1 */
+	int object_format; /* The format of the object file, OBJECT_TEXT (the default) or OBJECT_BINARY (--object=text, --object=binary) */
+	int mux; /* 1 to write all the output files of the source from the standard input to the standard output, as sections (--mux) */
+	int bounded_memory; /* 1 to stage the words in files as they are encoded, keeping only the words that wait for labels (--bounded-memory) */
+} AssemblerOptions;
+
+
+
+/**
+ * Reads the command line options, and separates them from the names of the source files.
+ * Options that are not given get their default values.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments (without the name of the program). The names of the source files are moved to its start.
+ * @param options The options to fill.
+ * @param out The stream that an error message is printed to.
+ * @return The number of source files, or ERROR if an option is not valid.
+ */
+int parse_options(int argc, char *argv[], AssemblerOptions *options, FILE *out);
+
+
+
+/**
+ * Counts the sources that are read from the standard input (named STREAM_NAME, "-") in a list of source files.
+ * The messages and statistics of a run with such a source are printed to the standard error,
+ * since its object file (or all its output files, as sections) is written to the standard output.
+ *
+ * @param files The names of the source files.
+ * @param num_files The number of source files.
+ * @return The number of sources from the standard input.
+ */
+int count_stream_sources(char *files[], int num_files);
+
+
+
+/**
+ * Assembles one source file: spreads its macros, runs the first and the second pass, and creates the output files.
+ *
+ * All the error and warning messages of the file are reported to the diagnostics of the context, and are not printed.
+ * For the source from the standard input ("-"), the output files are not created, they are written to streams
+ * (see the options ent_fd, ext_fd and mux) once the file is assembled without errors.
+ * The context must be empty (new or reset) when the function is called, and is left holding the state of the file.
+ *
+ * With bounded memory (--bounded-memory), the first pass takes the expanded source in chunks as the macros are spread,
+ * and every instruction word is written to a staging file next to the output files as soon as it is complete: right away,
+ * unless it refers to a label that is not defined yet, in which case it is overwritten in place once the label is defined
+ * (or in the second pass, for the labels of data lines). The data words are staged in a file of their own, and are appended
+ * after the instructions when the object file is written. The memory that is used then grows with the number of words that
+ * wait for labels, and with the symbol table, rather than with the length of the source.
+ *
+ * @param name_file The name of the source file (without the .as suffix).
+ * @param ctx The assembly context to use for the file.
+ * @param options The command line options.
+ * @return SUCCESS if the file was assembled and the output files were created, ERROR otherwise.
+ */
+int assemble_file(char *name_file, AssemblyContext *ctx, const AssemblerOptions *options);
+
+
+
+/**
+ * Assembles a list of source files one after the other, with a context that is kept from call to call
+ * (so that its buffers and tables are already allocated). The messages of each file are printed once it is done,
+ * followed by its statistics if they were asked for. The number of threads in the options is not used.
+ *
+ * @param files The names of the source files (without the .as suffix).
+ * @param num_files The number of source files.
+ * @param options The command line options.
+ * @param ctx The context to assemble the files with, it must be empty (new or reset) and is left reset.
+ * @param out The stream that the messages and the statistics are printed to.
+ * @return The number of files that had errors.
+ */
+int assemble_files_with_context(char *files[], int num_files, const AssemblerOptions *options, AssemblyContext *ctx, FILE *out);
+
+
+
+/**
+ * Assembles a list of source files, each one independently of the others.
+ *
+ * With one thread the files are assembled one after the other. With more threads, the files are assembled
+ * at the same time by a pool of worker threads: each worker has its own queue of files, and a worker whose
+ * queue is empty steals files from the queues of the other workers, so that a few large files do not leave
+ * the other workers idle. In both cases the messages of each file are printed in the order of the files
+ * in the list, followed by the statistics of the file if they were asked for.
+ *
+ * @param files The names of the source files (without the .as suffix).
+ * @param num_files The number of source files.
+ * @param options The command line options, including the number of worker threads.
+ * @param out The stream that the messages and the statistics are printed to.
+ * @return The number of files that had errors.
+ */
+int assemble_files(char *files[], int num_files, const AssemblerOptions *options, FILE *out);
+
+
+
+#endif
@@ -1,43 +1,59 @@
 #include "first_pass.h"
 #include "utils_and_checks.h"
 #include "linked_list.h"
+#include "context.h"
+#include "lexer.h"
+#include "memory.h"
+#include "output.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 
-int line_num_m = 0; /* Global variable for line number in files with suffix m, (used for error messages). */
+/* The field of every addressing mode in the first word of an instruction, for a source operand and for a target operand */
+static const int source_mode_field[NUM_ADDRESSING_MODES] = {
+	MODE_IMMEDIATE_BIT << SOURCE_MODE_SHIFT, MODE_DIRECT_BIT << SOURCE_MODE_SHIFT, 
+	MODE_INDIRECT_REGISTER_BIT << SOURCE_MODE_SHIFT, MODE_REGISTER_BIT << SOURCE_MODE_SHIFT
+};
+static const int target_mode_field[NUM_ADDRESSING_MODES] = {
+	MODE_IMMEDIATE_BIT << TARGET_MODE_SHIFT, MODE_DIRECT_BIT << TARGET_MODE_SHIFT, 
+	MODE_INDIRECT_REGISTER_BIT << TARGET_MODE_SHIFT, MODE_REGISTER_BIT << TARGET_MODE_SHIFT
+};
 
-/* Global variable IC (Instruction Counter) initialized to 100 - MEMORY_START_ADDRESS. 
-   This variable is used across multiple files to track the memory address of instructions. */
-int IC = MEMORY_START_ADDRESS;
 
-/* Global variable DC (Data Counter) initialized to 0.
-   This variable is used across multiple files to track the memory address of data. */
-int DC = 0;
+/* The additional word of every register, as a source operand (index 0) and as a target operand (index 1).
+   The source and target words of two registers do not overlap, so they are merged into one word with '|' */
+#define REGISTER_WORDS(shift) { \
+	(0 << shift) | ARE_ABSOLUTE, (1 << shift) | ARE_ABSOLUTE, (2 << shift) | ARE_ABSOLUTE, (3 << shift) | ARE_ABSOLUTE, \
+	(4 << shift) | ARE_ABSOLUTE, (5 << shift) | ARE_ABSOLUTE, (6 << shift) | ARE_ABSOLUTE, (7 << shift) | ARE_ABSOLUTE }
+static const int register_words[2][NUM_REGISTERS] = {REGISTER_WORDS(SOURCE_REG_SHIFT), REGISTER_WORDS(TARGET_REG_SHIFT)};
+#undef REGISTER_WORDS
 
 
+static void complete_waiting_words(SymbolNode *symbol_data, AssemblyContext *ctx);
 
-int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_data_list, node **head_instructions_list)
+
+int first_pass_analyze(AssemblyContext *ctx)
 {
-	int i = 0;
+	int i = 0, position, line_len;
 	int has_errors = 0, symbol_flag;
-	char line[MAX_LEN_LINE], *first_field, *data_type;
-	node *temp;
-	FILE *f;
+	const char *line, *line_end;
+	Token first_field, data_type;
 	
-	/* Initialize input file */
-	init_file(&f, name_file, ".am", "r");
-
 
-	while (fgets(line, MAX_LEN_LINE, f))
+	/* Go over the lines of the expanded source, that the macro stage left in the context.
+	   The lines are parsed in place: a line ends with its '\n' character, or with the null terminator of the buffer */
+	for (position = 0; position < ctx->expanded.length; position += line_len)
 	{
-		line_num_m++;
+		line = ctx->expanded.text + position;
+		line_end = (const char *)memchr(line, NEW_LINE, ctx->expanded.length - position);
+		line_len = line_end ? (int)(line_end - line) + 1 : ctx->expanded.length - position;
+		
+		ctx->line_num_m++;
 		
 	
 		/* Skips the current loop iteration if the line contains only whitespace characters (spaces, tabs, carriage returns, newlines) or is empty. */	
-		if (strspn(line, " \t\r\n") == strlen(line))
+		if (check_only_whitespace_after_index(line, 0) == SUCCESS)
 			continue;
 		
 		
@@ -48,17 +64,16 @@ int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_da
 	
 		i = 0;
 		symbol_flag = 0;
-		first_field = extract_word(line, &i);
+		lex_word(line, &i, &first_field);
 	
-		/* Checking if first_field is a definition of a symbol, by checking if the character that appears immediately after it is ':' */
-		if (line[i] == ':')
+		/* Checking if first_field is a definition of a symbol, (the lexer marks a word that is followed right away by ':') */
+		if (first_field.defines_label)
 		{
 			/* Error checking that there is no white character next to ':' */
-			if (!isspace(line[i+1]))
+			if (!(char_class[(unsigned char)line[i+1]] & CHAR_SPACE) && line[i+1] != NEW_LINE)
 			{
-				printf("Error in line number %d: A label with no whitespace after the ':'\n", line_num_m);
+				report(&ctx->diagnostics, "Error in line number %d: A label with no whitespace after the ':'\n", ctx->line_num_m);
 				has_errors = 1;
-				free(first_field);
 				continue;
 			}
 			
@@ -68,18 +83,16 @@ int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_da
 			/* Error checking for setting a label at the top of the line and the rest of the line is empty */
 			if (check_only_whitespace_after_index(line, i) == SUCCESS)
 			{
-				printf("Error in line number %d: A label at the top of the line and the rest of the line is empty\n", line_num_m);
+				report(&ctx->diagnostics, "Error in line number %d: A label at the top of the line and the rest of the line is empty\n", ctx->line_num_m);
 				has_errors = 1;
-				free(first_field);
 				continue;
 			}
 			
 			/* Error checking that the label name is a reserved word */
-			if (is_reserved_word(first_field) == SUCCESS)
+			if (is_reserved_token(&first_field))
 			{
-				printf("Error in line number %d: Reserved words (name of a operation, directive or register) cannot also be used as a label name\n", line_num_m);
+				report(&ctx->diagnostics, "Error in line number %d: Reserved words (name of a operation, directive or register) cannot also be used as a label name\n", ctx->line_num_m);
 				has_errors = 1;
-				free(first_field);
 				continue;
 			}
 			
@@ -88,14 +101,13 @@ int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_da
 		else
 		{
 			/* Error checking for parentheses not attached to the label name */
-			while (isspace(line[i]))
+			while (char_class[(unsigned char)line[i]] & CHAR_SPACE)
 				i++;
 			
 			if (line[i] == ':')
 			{
-				printf("Error in line number %d: A label definition must end with ':' and must be adjacent to the label name without any spaces\n", line_num_m);
+				report(&ctx->diagnostics, "Error in line number %d: A label definition must end with ':' and must be adjacent to the label name without any spaces\n", ctx->line_num_m);
 				has_errors = 1;
-				free(first_field);
 				continue;
 			}
 			else
@@ -103,103 +115,90 @@ int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_da
 		}
 		
 		/* Skip any whitespace. */	
-		while (isspace(line[i]))
+		while (char_class[(unsigned char)line[i]] & CHAR_SPACE)
 			i++;
 			
 		
 		if (line[i] == '.')
 		{
-			i++; /* to skip the '.' */
-			data_type = extract_word(line, &i); /* Extract the next word from the line as the data type. */
+			lex_word(line, &i, &data_type); /* Extract the next word from the line as the data type (with its '.'). */
 			
 			if (symbol_flag)
 			{
 				/* Create a symbol node if the label is valid and not associated with an entry or extern directive. */
-				if (is_valid_symbol(first_field) == ERROR)
+				if (!is_symbol_token(&first_field))
                 		{
-                   		 	printf("Error in line number %d: Invalid label. A valid label begins with an alphabetic letter (uppercase or lowercase), followed by some series of alphabetic letters (uppercase or lowercase) and/or numbers. The maximum length of a label is 31 characters\n", line_num_m);
+                   		 	report(&ctx->diagnostics, "Error in line number %d: Invalid label. A valid label begins with an alphabetic letter (uppercase or lowercase), followed by some series of alphabetic letters (uppercase or lowercase) and/or numbers. The maximum length of a label is 31 characters\n", ctx->line_num_m);
                     			has_errors = 1;
-                    			free(first_field);
-					free(data_type);
                     			continue;
                 		}
                 
                 		/* The label defined at the beginning of the .entry or .extern line is meaningless and the assembler ignores this label */
-                		else if (strcmp(data_type, "entry") == 0 || strcmp(data_type, "extern") == 0)
+                		else if (data_type.type == TOKEN_DIRECTIVE && (data_type.value == DIRECTIVE_ENTRY || data_type.value == DIRECTIVE_EXTERN))
                 		{
-                    			printf("Warning: a label defined at the beginning of the .entry or .extern line is meaningless\n");
+                    			report(&ctx->diagnostics, "Warning: a label defined at the beginning of the .entry or .extern line is meaningless\n");
                 		}
                 
                 		else
-                    			crate_symbol_node(first_field, DC, 1, 0, 0, head_symbols_list);
+                		{
+                			/* A label cannot have the name of a macro */
+                			if (check_macro_symbol_conflict(first_field.start, first_field.length, ctx->line_num_m, &ctx->macros, &ctx->diagnostics) == ERROR)
+                				has_errors = 1;
+                			
+                			if (define_symbol(&ctx->symbols, first_field.start, first_field.length, ctx->DC, 1, ctx->line_num_m) == ERROR)
+                    				has_errors = 1;
+                		}
 				
 			}
 
 			/* Encode the data from the line. If an error occurs, mark it and continue to the next line. */
-			DC = encoding_data(line, &i, data_type, DC, head_data_list, head_symbols_list);
-			if (DC == ERROR)
+			if (encoding_data(line, &i, &data_type, ctx) == ERROR)
 			{
 				has_errors = 1;
-				free(first_field);
-				free(data_type);
 				continue;
 			}
 			
-			free(data_type);
 		}
 		else
 		{		
 			if (symbol_flag)
 			{
 				/* Create a symbol node if the label is valid */
-				if (is_valid_symbol(first_field) == ERROR)
+				if (!is_symbol_token(&first_field))
                 		{
-                   		 	printf("Error in line number %d: Invalid label. A valid label begins with an alphabetic letter (uppercase or lowercase), followed by some series of alphabetic letters (uppercase or lowercase) and/or numbers. The maximum length of a label is 31 characters\n", line_num_m);
+                   		 	report(&ctx->diagnostics, "Error in line number %d: Invalid label. A valid label begins with an alphabetic letter (uppercase or lowercase), followed by some series of alphabetic letters (uppercase or lowercase) and/or numbers. The maximum length of a label is 31 characters\n", ctx->line_num_m);
                     			has_errors = 1;
-                    			free(first_field);
                     			continue;
                 		}
                 		else
-					crate_symbol_node(first_field, IC, 0, 0, 0, head_symbols_list);
+                		{
+                			/* A label cannot have the name of a macro */
+                			if (check_macro_symbol_conflict(first_field.start, first_field.length, ctx->line_num_m, &ctx->macros, &ctx->diagnostics) == ERROR)
+                				has_errors = 1;
+                			
+                			if (define_symbol(&ctx->symbols, first_field.start, first_field.length, ctx->IC, 0, ctx->line_num_m) == ERROR)
+                    				has_errors = 1;
+                			
+                			/* With bounded memory, the words that wait for the label are completed as soon as it is defined */
+                			else if (ctx->bounded_memory)
+                				complete_waiting_words(find_symbol(&ctx->symbols, first_field.start, first_field.length), ctx);
+                		}
 			}
 			
 			/* Encode the instructions from the line. If an error occurs, mark it and continue to the next line. */
-			IC = encoding_instructions(line, &i, IC, head_instructions_list);
-			if (IC == ERROR)
+			if (encoding_instructions(line, &i, ctx) == ERROR)
 			{
 				has_errors = 1;
-				free(first_field);
 				continue;
 			}
 		}
 		
-		free(first_field);
 		
 	}
 
 
-	/* If there are no errors, adjust the addresses for data and symbols before data (If there are errors then no output files are created, so there is no point in the address being updated) */
-	if (!has_errors)
-	{
-		/* Iterate through the data list */
-		temp = *head_data_list;
-		while(temp != NULL)
-		{	
-			/* Update the address for each data node by adding IC */
-			((CodeNode *)(temp->data))->adress += IC;
-			temp = (node *)temp->next;
-		}
-	
-		/* Iterate through the symbols list */
-		temp = *head_symbols_list;
-		while(temp != NULL)
-		{	
-			/* Update the address for each symbol marked as 'before_data' */
-			if(((SymbolNode *)(temp->data))->before_data)
-				((SymbolNode *)(temp->data))->adress += IC;
-			temp = (node *)temp->next;
-		}
-	}
+	/* The data addresses and the addresses of the data labels stay relative to the data section,
+	   the data section starts right after the instructions (at the final IC), which is applied when they are used */
 	
 	
 	return has_errors;
@@ -207,61 +206,29 @@ int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_da
 
 
 
-void crate_symbol_node(char *new_name, int adress, int before_data, int is_entry, int is_extern, node **head)
+int encoding_data(const char *line, int *start_index, const Token *data_type, AssemblyContext *ctx)
 {
-	/* Allocate memory for a new symbol node */
-	SymbolNode *node_data = (SymbolNode *)malloc(sizeof(SymbolNode));
+	Token symbol_name;
+	int i = *start_index, num, comma;
+
 	
-	if (!node_data) 
+	/* Error checking for a directive that does not exist */
+	if (data_type->type != TOKEN_DIRECTIVE)
 	{
-		printf("Allocation failure\n");
-		exit(1);
+		report(&ctx->diagnostics, "Error in line number %d: Directive '%.*s' does not exist\n", ctx->line_num_m, data_type->length, data_type->start);
+		return ERROR;
 	}
 	
-	/*Initialize the symbol node with the provided values */
-	node_data->name = (char *)malloc(strlen(new_name) + 1);
-	if (!node_data->name)
-	{
-        	printf("Allocation failure\n");
-        	free(node_data);
-		exit(1);
-	}
-	strcpy(node_data->name, new_name);
-
-	node_data->adress = adress;
-	node_data->before_data = before_data;
-	node_data->is_entry = is_entry;
-	node_data->is_extern = is_extern;
-	node_data ->line_num = line_num_m;
-
-	/* Add the node to the end of the symbol linked list */
-	add_node_end(head, (void *)node_data, delete_symbol_node);
-}
-
-
-
-
-int encoding_data(char *line, int *start_index, char *data_type, int DC, node **head_data_list, node **head_symbols_list)
-{
-	char *data, *symbol_name;
-	int i = *start_index, num, comma = 0;
-
-	
-	if (strcmp(data_type, "data") == 0)
+	if (data_type->value == DIRECTIVE_DATA)
 	{
 		/* Skip over any spaces or commas in the line, count the commas */
-		while (isspace(line[i]) || line[i] == ',')
-		{
-			if (line[i] == ',')
-				comma++;
-			i++;
-		}
+		comma = skip_commas(line, &i);
 
 		/* Validate that there is no comma = the number of commas is 0 before the first number */
-		if (is_valid_comma_count(comma, 0, line_num_m) == ERROR)
+		if (is_valid_comma_count(comma, 0, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 			return ERROR;
 			
-		while (line[i])
+		while (line[i] != NEW_LINE && line[i] != EOS)
 		{
 	
 			num = extract_number(line, &i);	
@@ -269,34 +236,26 @@ int encoding_data(char *line, int *start_index, char *data_type, int DC, node **
 			/* Validate that the number is valid: it must be a whole number and within the correct range. */
 			if (is_valid_number(num, CODE_WORD_LEN) == ERROR || line[i] == '.')
 			{
-				printf("Error in line number %d: Invalid number\n", line_num_m);
+				report(&ctx->diagnostics, "Error in line number %d: Invalid number\n", ctx->line_num_m);
 				return ERROR;
 			}
 			
-			data = int_to_binary(num, CODE_WORD_LEN); /*  Convert the number to a binary string. */
-			crate_data_or_instruction_node(data, DC, head_data_list); /* Create a data node with the binary string and add it to the data list. */	
-			DC++;
-			free(data);
+			/* Add the number (15 bits, 2's complement) to the data image. */
+			add_data_word((uint16_t)(num & WORD_MASK), ctx);
 			
-			comma = 0;
-			while (isspace(line[i]) || line[i] == ',')
-			{
-				if(line[i] == ',')
-					comma++;
-				i++;
-			}
+			comma = skip_commas(line, &i);
 
 			
-			if (line[i])
+			if (line[i] != NEW_LINE && line[i] != EOS)
 			{
 				/* Validate that there is exactly 1 comma between the numbers */
-				if (is_valid_comma_count(comma, 1, line_num_m) == ERROR)
+				if (is_valid_comma_count(comma, 1, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 					return ERROR;
 			}
 			else /* end of line */
 			{
 				/* Validate that there is no comma = the number of commas is 0 after the last number */
-				if (is_valid_comma_count(comma, 0, line_num_m) == ERROR)
+				if (is_valid_comma_count(comma, 0, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 					return ERROR;
 			}	
 		}
@@ -305,15 +264,15 @@ int encoding_data(char *line, int *start_index, char *data_type, int DC, node **
 		/* Check for extra characters after the current index */
 		if (check_only_whitespace_after_index(line, i) == ERROR)
 		{
-			printf("Error in line number %d: Extra characters at the end of a line\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: Extra characters at the end of a line\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
 	}
-	else if (strcmp(data_type, "string") == 0)
+	else if (data_type->value == DIRECTIVE_STRING)
 	{
 		/* Skip any leading whitespace. */
-		while (isspace(line[i] ))
+		while (char_class[(unsigned char)line[i]] & CHAR_SPACE)
 			i++;
 		
 		/* Check for the opening double quote of the string. */	
@@ -322,21 +281,18 @@ int encoding_data(char *line, int *start_index, char *data_type, int DC, node **
 		else
 		{
 			/*  If no opening quote is found, return an error. */
-			printf("Error in line number %d: Invalid string\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: Invalid string\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
 		/* Loop through the characters of the string. */
-		while (isalpha(line[i]) || isspace(line[i]))
+		while (char_class[(unsigned char)line[i]] & (CHAR_ALPHA | CHAR_SPACE))
 		{
 			/* Process each non-whitespace character. */
-			if (!isspace(line[i]))
+			if (char_class[(unsigned char)line[i]] & CHAR_ALPHA)
 			{
-				/* Convert the character to its binary form and create a data node. */
-				data = int_to_binary((int)line[i], CODE_WORD_LEN);
-				crate_data_or_instruction_node(data, DC, head_data_list);
-				DC++;
-				free(data);
+				/* Add the character code to the data image. */
+				add_data_word((uint16_t)line[i], ctx);
 			}
 			i++;	
 		}
@@ -347,63 +303,72 @@ int encoding_data(char *line, int *start_index, char *data_type, int DC, node **
 		else
 		{
 			/* If no closing quote is found, return an error. */
-			printf("Error in line number %d: Invalid string\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: Invalid string\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
 		
-		/* Add the string terminator (null character in binary form) as a data node. */
-		crate_data_or_instruction_node("000000000000000", DC, head_data_list);
-		DC++;
+		/* Add the string terminator (null character) as a data node. */
+		add_data_word(0, ctx);
 		
 		/* Check for extra characters after the current index */
 		if (check_only_whitespace_after_index(line, i) == ERROR)
 		{
-			printf("Error in line number %d: The '.string' directive accepts only one string\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: The '.string' directive accepts only one string\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
 	}
-	else if (strcmp(data_type, "entry") == 0)
+	else if (data_type->value == DIRECTIVE_ENTRY)
 	{
-		symbol_name = extract_word(line, &i);
+		lex_word(line, &i, &symbol_name);
 		
 		/* Check for extra characters after the current index */
 		if (check_only_whitespace_after_index(line, i) == ERROR)
 		{
-			printf("Error in line number %d: The directive '.entry' accepts only one parameter\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: The directive '.entry' accepts only one parameter\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
-		crate_symbol_node(symbol_name, TEMP_ENTRY_ADDRESS, 0, 1, 0, head_symbols_list);
+		/* An entry label cannot have the name of a macro */
+		if (check_macro_symbol_conflict(symbol_name.start, symbol_name.length, ctx->line_num_m, &ctx->macros, &ctx->diagnostics) == ERROR)
+			return ERROR;
+		
+		if (declare_entry_symbol(&ctx->symbols, symbol_name.start, symbol_name.length, ctx->line_num_m) == ERROR)
+			return ERROR;
 	}
-	else if (strcmp(data_type, "extern") == 0)
+	else if (data_type->value == DIRECTIVE_EXTERN)
 	{
-		symbol_name = extract_word(line, &i);
+		lex_word(line, &i, &symbol_name);
 		
 		/* Check for extra characters after the current index */
 		if (check_only_whitespace_after_index(line, i) == ERROR)
 		{
-			printf("Error in line number %d: The directive '.extern' accepts only one parameter\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: The directive '.extern' accepts only one parameter\n", ctx->line_num_m);
 			return ERROR;
 		}
 		
-		crate_symbol_node(symbol_name, 0, 0, 0, 1, head_symbols_list);
+		/* An external label cannot have the name of a macro */
+		if (check_macro_symbol_conflict(symbol_name.start, symbol_name.length, ctx->line_num_m, &ctx->macros, &ctx->diagnostics) == ERROR)
+			return ERROR;
+		
+		if (declare_extern_symbol(&ctx->symbols, symbol_name.start, symbol_name.length, ctx->line_num_m) == ERROR)
+			return ERROR;
 	}
 
 	
 	*start_index = i;
-	return DC;
+	return SUCCESS;
 }
 
 
 
-int extract_number(char *line, int *start_index) 
+int extract_number(const char *line, int *start_index) 
 {
 	int i = *start_index, num = 0, sign = 1;
 	
 	/* Skip leading whitespace characters */
-	while (isspace(line[i]))
+	while (char_class[(unsigned char)line[i]] & CHAR_SPACE)
 		i++;
 	
 	/*  Check for a sign (+ or -) */
@@ -416,7 +381,7 @@ int extract_number(char *line, int *start_index)
         	i++;
         	
         /* Extract digits to form the number */
-	while (isdigit(line[i]))
+	while (char_class[(unsigned char)line[i]] & CHAR_DIGIT)
 	{	
 		num = num*10 + (line[i] - '0');
 		i++;
@@ -434,183 +399,248 @@ int extract_number(char *line, int *start_index)
 
 
 
-void crate_data_or_instruction_node(char *code_word, int adress, node **head)
+/* Records that a code word waits for the address of a label. Returns the index of the fixup */
+static int add_fixup(AssemblyContext *ctx, int word, int symbol)
 {
-	/* Allocate memory for a new data node */
-	CodeNode *node_data = (CodeNode *)malloc(sizeof(CodeNode));
+	Fixup *fixup;
+	int index;
 	
-	if (!node_data) 
+	/* With bounded memory, the fixups of the words that were completed are reused */
+	if (ctx->free_fixups > 0)
 	{
-		printf("Allocation failure\n");
-		exit(1);
+		index = ctx->free_fixups - 1;
+		ctx->free_fixups = ctx->fixups[index].next;
 	}
-
-	/* Initialize the data node with the provided values */
-	node_data->code_word = (char *)malloc(strlen(code_word) + 1);
-	if (!node_data->code_word)
+	else
 	{
-        	printf("Allocation failure\n");
-        	free(node_data);
-		exit(1);
+		if (ctx->num_fixups == ctx->fixups_capacity)
+		{
+			ctx->fixups_capacity = ctx->fixups_capacity ? 2 * ctx->fixups_capacity : FIXUPS_INIT_CAPACITY;
+			ctx->fixups = (Fixup *)memory_realloc(ctx->fixups, ctx->fixups_capacity * sizeof(Fixup), MEMORY_CODE);
+		}
+		index = ctx->num_fixups++;
 	}
-	strcpy(node_data->code_word, code_word);
 	
-	node_data->adress = adress;
-	node_data->line_num = line_num_m;
+	fixup = &ctx->fixups[index];
+	fixup->word = word;
+	fixup->symbol = symbol;
+	fixup->line_num = ctx->line_num_m;
+	fixup->next = 0;
+	
+	return index;
+}
 
-	/* Add the node to the end of the data linked list */
-	add_node_end(head,(void *)node_data, delete_code_node);
+
+
+void complete_staged_word(AssemblyContext *ctx, int word, uint16_t code_word)
+{
+	char digits[OCTAL_WORD_WIDTH];
+	
+	/* The octal digits end the line of the word, right before its '\n' character */
+	output_octal_word(digits, code_word);
+	staging_overwrite(&ctx->staged_code, output_word_offset(MEMORY_START_ADDRESS, MEMORY_START_ADDRESS + word + 1) - OCTAL_WORD_WIDTH - 1, digits, OCTAL_WORD_WIDTH);
 }
 
 
 
-int encoding_instructions(char *line, int *start_index, int IC, node **head_instructions_list)
+/* With bounded memory, completes the words that wait for a label that was just defined on an instruction line,
+   and frees their fixups */
+static void complete_waiting_words(SymbolNode *symbol_data, AssemblyContext *ctx)
 {
-	char *first_code_word, *second_code_word = NULL, *third_code_word = NULL;
-	char *operation_name, *op_code, *first_operand, *second_operand;
-	int i = *start_index, op_code_index, num_operands, comma = 0;
-	int addressing_mode1, addressing_mode2;
-	int source_methods[NUM_ADDRESSING_MODES] = {0}, target_methods[NUM_ADDRESSING_MODES] = {0};
-	const char *addressing_mode_coding[] = {"0001", "0010", "0100", "1000"};
+	Fixup *fixup;
+	int index, next;
+	uint16_t code_word = (uint16_t)(((symbol_data->adress & OPERAND_MASK) << ARE_BITS) | ARE_RELOCATABLE);
+	
+	for (index = symbol_data->waiting; index > 0; index = next)
+	{
+		fixup = &ctx->fixups[index - 1];
+		next = fixup->next;
+		
+		complete_staged_word(ctx, fixup->word, code_word);
+		
+		fixup->symbol = -1;
+		fixup->next = ctx->free_fixups;
+		ctx->free_fixups = index;
+	}
+	
+	symbol_data->waiting = 0;
+}
+
 
-	/* Allocate memory for the first code word */
-	first_code_word = (char *)malloc(CODE_WORD_LEN * sizeof(char));
-	if (!first_code_word)
+
+/* With bounded memory, writes an instruction word to the staged code. A word with a label operand is complete right away
+   if the label is already external or defined on an instruction line, otherwise it is written as 0 and waits for the label */
+static void stage_instruction_word(uint16_t code_word, const Token *label, AssemblyContext *ctx)
+{
+	StagedExtern reference;
+	SymbolNode *symbol_data;
+	int symbol, index;
+	
+	if (label != NULL)
 	{
-		printf("Allocation failure\n");
-		exit(1);
+		symbol = reference_symbol(&ctx->symbols, label->start, label->length, ctx->line_num_m);
+		symbol_data = &ctx->symbols.symbols[symbol];
+		
+		if (symbol_data->is_extern)
+		{
+			code_word = ARE_EXTERNAL;
+			reference.address = ctx->IC;
+			reference.symbol = symbol;
+			staging_append(&ctx->staged_externals, (const char *)&reference, sizeof(reference));
+		}
+		else if (symbol_data->is_defined && !symbol_data->before_data)
+			code_word = (uint16_t)(((symbol_data->adress & OPERAND_MASK) << ARE_BITS) | ARE_RELOCATABLE);
+		else
+		{
+			/* The fixups that wait for the same label are linked from the label */
+			index = add_fixup(ctx, ctx->IC - MEMORY_START_ADDRESS, symbol);
+			ctx->fixups[index].next = symbol_data->waiting;
+			symbol_data->waiting = index + 1;
+		}
 	}
 	
-	/* Skip initial whitespaces and commas before the first operand */
-	while (line[i] && (isspace(line[i]) || line[i] == ','))
+	output_word(&ctx->staged_code.buffer, ctx->IC, code_word);
+	staging_spill(&ctx->staged_code);
+	ctx->IC++;
+}
+
+
+
+void add_data_word(uint16_t code_word, AssemblyContext *ctx)
+{
+	/* The word is at index DC of the data image */
+	if (ctx->bounded_memory)
+		staging_append(&ctx->staged_data, (const char *)&code_word, sizeof(code_word));
+	else
+		word_image_append(&ctx->data, code_word);
+	ctx->DC++;
+}
+
+
+
+void add_instruction_word(uint16_t code_word, const Token *label, AssemblyContext *ctx)
+{
+	int word;
+	
+	if (ctx->bounded_memory)
 	{
-		if (line[i] == ',')
-			comma++;
-		i++;
+		stage_instruction_word(code_word, label, ctx);
+		return;
 	}
+	
+	/* The word is at index IC - MEMORY_START_ADDRESS of the code image */
+	word = word_image_append(&ctx->code, code_word);
+	ctx->IC++;
+	
+	/* A word with a label operand is completed in the second pass */
+	if (label != NULL)
+		add_fixup(ctx, word, reference_symbol(&ctx->symbols, label->start, label->length, ctx->line_num_m));
+}
+
+
+
+int encoding_instructions(const char *line, int *start_index, AssemblyContext *ctx)
+{
+	int first_code_word, second_code_word = NO_CODE_WORD, third_code_word = NO_CODE_WORD;
+	Token operation_name, first_operand, second_operand;
+	const Token *second_label = NULL, *third_label = NULL; /* Label operands, resolved in the second pass */
+	int i = *start_index, comma;
+	int addressing_mode1, addressing_mode2;
+	const Operation *operation;
+	
+	/* Skip initial whitespaces and commas before the first operand */
+	comma = skip_commas(line, &i);
 
 	/* Validate that there is no comma = the number of commas is 0 before the first operand */
-	if (is_valid_comma_count(comma, 0, line_num_m) == ERROR)
+	if (is_valid_comma_count(comma, 0, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 		return ERROR; 
 		
 	
 	/* Extract operation name and find its index in the operation names table */
-	operation_name = extract_word(line, &i);
-	op_code_index = find_op_index(operation_name);
+	lex_word(line, &i, &operation_name);
 	
 	/* Error checking for action name that does not exist */
-	if (op_code_index == ERROR)
+	if (operation_name.type != TOKEN_MNEMONIC)
 	{
-		printf("Error in line number %d: Operation name '%s' does not exist. \nNote that the function name and the first operand are separated with white characters\n", line_num_m, operation_name);
-		free(operation_name);	
+		report(&ctx->diagnostics, "Error in line number %d: Operation name '%.*s' does not exist. \nNote that the function name and the first operand are separated with white characters\n", ctx->line_num_m, operation_name.length, operation_name.start);
 		return ERROR;
 	}
+	operation = &op_names_table[operation_name.value];
 	
-	free(operation_name);
 
-	/* Get the operation code and initialize the first code word */
-	op_code = op_names_table[op_code_index].operation_code;
-	strcpy(first_code_word, op_code);
-	
-	/* Get the number of operands and their addressing methods */
-	 num_operands = information_operation(op_code_index, source_methods, target_methods);
+	/* Initialize the first code word with the operation code (bits 11-14), 
+	   and the ARE field (A = 1, R = 0, E = 0) as this is an absolute instruction */
+	first_code_word = (operation->operation_code << OPCODE_SHIFT) | ARE_ABSOLUTE;
 		
 	
-	/* Handle encoding based on the number of operands */			
-	switch (num_operands) {
-		case 0:
-			/* No operands: . The fields of the source operand and the destination operand in the first word of the instruction are unused, and therefore will be zeroed */
-			strcat(first_code_word, "00000000");
-			break;
-		
+	/* Handle encoding based on the number of operands.
+	   With no operands, the fields of the source operand and the destination operand in the first word of the instruction are unused, and therefore stay zeroed */			
+	switch (operation->num_operands) {
 		case 1:	
 			/* Handle a single operand, find its addressing mode, and encode it in the first code word */		
-			addressing_mode1 = handle_operand(line, &i, &first_operand, target_methods);
+			addressing_mode1 = handle_operand(line, &i, &first_operand, operation->target_modes, ctx);
 			if (addressing_mode1 == ERROR)
-			{
-				free(first_operand);
 				return ERROR;
-			}
 			
-			/* , the field of the source operand (bits 7-10) in the first word of the instruction encoding is meaningless, and therefore will contain zeros */	
-			strcat(first_code_word, "0000");
-			strcat(first_code_word, addressing_mode_coding[addressing_mode1]);
+			/* The field of the source operand (bits 7-10) in the first word of the instruction encoding is meaningless, and therefore will contain zeros */	
+			first_code_word |= target_mode_field[addressing_mode1];
 			
 			/* Encode the operand itself in a separate code word */
-			second_code_word = operand_encoding(first_operand, addressing_mode1, 0);
-			if (second_code_word == NULL)
-			{
-				free(first_operand);
+			second_code_word = operand_encoding(&first_operand, addressing_mode1, 0, ctx);
+			if (second_code_word == ERROR)
 				return ERROR;
-			}
 			
-			free(first_operand);	
+			/* The label name is kept so that it can be replaced with this label address in a second pass */
+			if (addressing_mode1 == MODE_DIRECT)
+				second_label = &first_operand;
 			break;
 		case 2:
 			/* Handle two operands, starting with the source operand */
-			addressing_mode1 = handle_operand(line, &i, &first_operand, source_methods);
+			addressing_mode1 = handle_operand(line, &i, &first_operand, operation->source_modes, ctx);
 			if (addressing_mode1 == ERROR)
-			{
-				free(first_operand);
 				return ERROR;
-			}
 				
-			/* Append addressing mode of the source operand to the first code word */	
-			strcat(first_code_word, addressing_mode_coding[addressing_mode1]);
+			/* Set the addressing mode of the source operand in the first code word */	
+			first_code_word |= source_mode_field[addressing_mode1];
 			
 			/* Encode the source operand in a separate code word */
-			second_code_word = operand_encoding(first_operand, addressing_mode1, 0);
-			if (second_code_word == NULL)
-			{
-				free(first_operand);
+			second_code_word = operand_encoding(&first_operand, addressing_mode1, 0, ctx);
+			if (second_code_word == ERROR)
 				return ERROR;
-			}
 			
-			free(first_operand);
+			if (addressing_mode1 == MODE_DIRECT)
+				second_label = &first_operand;
 	
 			/* Skip whitespace or commas before the second operand */
-			comma = 0;	
-			while (line[i] && (isspace(line[i]) || line[i] == ','))
-			{
-				if (line[i] == ',')
-					comma++;
-				i++;
-			}
+			comma = skip_commas(line, &i);
 
 			/* Validate that there is exactly 1 comma between the operands */
-			if (is_valid_comma_count(comma, 1, line_num_m) == ERROR)
+			if (is_valid_comma_count(comma, 1, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 				return ERROR;
 			
 			/* Handle the target operand and find its addressing mode */
-			addressing_mode2 = handle_operand(line, &i, &second_operand, target_methods);	
+			addressing_mode2 = handle_operand(line, &i, &second_operand, operation->target_modes, ctx);	
 			if (addressing_mode2 == ERROR)
-			{
-				free(second_operand);
 				return ERROR;
-			}
 				
 			
-			/* Append addressing mode of the target operand to the first code word */	
-			strcat(first_code_word, addressing_mode_coding[addressing_mode2]);
+			/* Set the addressing mode of the target operand in the first code word */	
+			first_code_word |= target_mode_field[addressing_mode2];
 			
 			/* Encode the target operand in a separate code word */
-			third_code_word = operand_encoding(second_operand, addressing_mode2, 1);
-			if (third_code_word == NULL)
-			{
-				free(second_operand);
+			third_code_word = operand_encoding(&second_operand, addressing_mode2, 1, ctx);
+			if (third_code_word == ERROR)
 				return ERROR;
-			}
 			
-			free(second_operand);
+			if (addressing_mode2 == MODE_DIRECT)
+				third_label = &second_operand;
 			
 			/* Special case: if both operands use indirect or direct register addressing (addressing_mode 2 or 3), 
-			   they can be encoded in the same code word, so we merge them */
-			if((addressing_mode1 == 2 || addressing_mode1 == 3) && (addressing_mode2 == 2 || addressing_mode2 == 3))
+			   they can be encoded in the same code word, so we merge them (the register fields do not overlap) */
+			if ((MODES_REGISTERS >> addressing_mode1) & (MODES_REGISTERS >> addressing_mode2) & 1)
 			{
-				second_code_word[9] = third_code_word[9];
-				second_code_word[10] = third_code_word[10];
-				second_code_word[11] = third_code_word[11];
-				third_code_word = NULL; /*  The third code word is no longer needed */
+				second_code_word |= third_code_word;
+				third_code_word = NO_CODE_WORD; /*  The third code word is no longer needed */
 			}
 				
 			break;
@@ -620,96 +650,36 @@ int encoding_instructions(char *line, int *start_index, int IC, node **head_inst
 			
 	
 	/* Skip any whitespace or commas after the last operand */
-	comma = 0;	
-	while (line[i] && (isspace(line[i]) || line[i] == ','))
-	{
-		if (line[i] == ',')
-			comma++;
-		i++;
-	}
+	comma = skip_commas(line, &i);
 	
 	/* Validate that there is no comma = the number of commas is 0 after the last operand */
-	if (is_valid_comma_count(comma, 0, line_num_m) == ERROR)
+	if (is_valid_comma_count(comma, 0, ctx->line_num_m, &ctx->diagnostics) == ERROR)
 		return ERROR;
 
 	/* Check for extra operand after the current index */
 	if (check_only_whitespace_after_index(line, i) == ERROR)
 	{
-		printf("Error in line number %d: Extra operand\n", line_num_m);
+		report(&ctx->diagnostics, "Error in line number %d: Extra operand\n", ctx->line_num_m);
 		return ERROR;
 	}				
 	
-	/* Set the ARE field (A = 1, R = 0, E = 0) for the first code word as this is an absolute instruction */
-	strcat(first_code_word, "100");
-	
-	/* Create a node for the first code word and add it to the instructions list */
-	crate_data_or_instruction_node(first_code_word, IC, head_instructions_list);
-	IC++;
-	
-	/* If there is a second code word (for the first operand), create a node and add it to the list */
-	if (second_code_word)
-	{
-		crate_data_or_instruction_node(second_code_word, IC, head_instructions_list);
-		IC++;
-	}	
+	/* Add the first code word to the code image */
+	add_instruction_word((uint16_t)first_code_word, NULL, ctx);
 	
-	/* If there is a third code word (for the second operand), create a node and add it to the list */
-	if (third_code_word)
-	{
-		crate_data_or_instruction_node(third_code_word, IC, head_instructions_list);
-		IC++;
-	}
+	/* If there is a second code word (for the first operand), add it after the first one */
+	if (second_code_word != NO_CODE_WORD)
+		add_instruction_word((uint16_t)second_code_word, second_label, ctx);
 	
+	/* If there is a third code word (for the second operand), add it after the second one */
+	if (third_code_word != NO_CODE_WORD)
+		add_instruction_word((uint16_t)third_code_word, third_label, ctx);
 	
-	/* Free allocated memory */
-	free(first_code_word);
-	free(second_code_word);
-	free(third_code_word);
-	
-	return IC; /* Return the updated instruction counter */
+	return SUCCESS;
 }
 
 
 
-int information_operation(int index, int source_methods[], int target_methods[])
-{
-	int i;
-	/* Define a table of instructions with their respective properties. */
-	Instruction instructions_table[] = {
-        {"mov", 2, {1, 1, 1, 1}, {0, 1, 1, 1}},
-        {"cmp", 2, {1, 1, 1, 1}, {1, 1, 1, 1}},
-        {"add", 2, {1, 1, 1, 1}, {0, 1, 1, 1}},
-        {"sub", 2, {1, 1, 1, 1}, {0, 1, 1, 1}},
-        {"lea", 2, {0, 1, 0, 0}, {0, 1, 1, 1}},
-        {"clr", 1, {0, 0, 0, 0}, {0, 1, 1, 1}},
-        {"not", 1, {0, 0, 0, 0}, {0, 1, 1, 1}},
-        {"inc", 1, {0, 0, 0, 0}, {0, 1, 1, 1}},
-        {"dec", 1, {0, 0, 0, 0}, {0, 1, 1, 1}},
-        {"jmp", 1, {0, 0, 0, 0}, {0, 1, 1, 0}},
-        {"bne", 1, {0, 0, 0, 0}, {0, 1, 1, 0}},
-        {"red", 1, {0, 0, 0, 0}, {0, 1, 1, 1}},
-        {"prn", 1, {0, 0, 0, 0}, {1, 1, 1, 1}},
-        {"jsr", 1, {0, 0, 0, 0}, {0, 1, 1, 0}},
-        {"rts", 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
-        {"stop", 0, {0, 0, 0, 0}, {0, 0, 0, 0}}
-	};
-    
-    
-	/*Directly copy from instructions_table to passed arrays*/
-	for (i = 0; i < NUM_ADDRESSING_MODES; i++) 
-	{
-        	source_methods[i] = instructions_table[index].source_methods[i];
-        	target_methods[i] = instructions_table[index].target_methods[i];
-	}
-    
-	
-	/* Return the number of operands for the instruction. */		
-	return instructions_table[index].num_operands;
-}
-
-
-
-int handle_operand(char *line, int *start_index, char **operand, int adressing_methods[])
+int handle_operand(const char *line, int *start_index, Token *operand, int legal_modes, AssemblyContext *ctx)
 {
 	int i = *start_index;
 	int addressing_mode;
@@ -718,24 +688,24 @@ int handle_operand(char *line, int *start_index, char **operand, int adressing_m
 	/* Check for missing operand after the current index */
 	if (check_only_whitespace_after_index(line, i) == SUCCESS)
 	{
-		printf("Error in line number %d: Missing operand\n", line_num_m);
+		report(&ctx->diagnostics, "Error in line number %d: Missing operand\n", ctx->line_num_m);
 		return ERROR;
 	}
 	
 	/* Extract the next operand from the line */		
-	*operand = extract_word(line, &i);
+	lex_word(line, &i, operand);
 	
 	/* Determine the addressing mode of the operand */		
-	addressing_mode = find_addressing_mode(*operand);
+	addressing_mode = find_addressing_mode(operand, ctx);
 	
 	/* If an error occurs during addressing mode determination, return ERROR for the analyzing of the input line to finish*/		
 	if (addressing_mode == ERROR)
 		return ERROR;
 	
 	/* Validate that the addressing mode is allowed for the operation */	
-	if (adressing_methods[addressing_mode] == 0)
+	if (((legal_modes >> addressing_mode) & 1) == 0)
 	{
-		printf("Error in line number %d: An operand type that does not match the operation\n", line_num_m);
+		report(&ctx->diagnostics, "Error in line number %d: An operand type that does not match the operation\n", ctx->line_num_m);
 		return ERROR;
 	}
 	
@@ -746,168 +716,92 @@ int handle_operand(char *line, int *start_index, char **operand, int adressing_m
 
 
 
-int find_addressing_mode(char *operand)
+int find_addressing_mode(const Token *operand, AssemblyContext *ctx)
 {
 	/* If the operand starts with '#', it's an immediate addressing mode */
-	if (operand[0] == '#')
-		return 0;
+	if (operand->type == TOKEN_IMMEDIATE)
+		return MODE_IMMEDIATE;
 		
 	/* If the operand starts with '*', it could be an indirect register mode */
-	if (operand[0] == '*')/* Check if the rest of the operand is a valid register */
+	if (operand->length > 0 && operand->start[0] == '*')/* Check if the rest of the operand is a valid register */
 	{
-		if (is_register(operand+1) == SUCCESS)
-			return 2;/* Indirect register mode */
+		if (operand->type == TOKEN_INDIRECT_REGISTER)
+			return MODE_INDIRECT_REGISTER;
 			
 		else /* Invalid register name */	
 		{
-			printf("Error in line number %d: Invalid register name\n", line_num_m);
+			report(&ctx->diagnostics, "Error in line number %d: Invalid register name\n", ctx->line_num_m);
 			return ERROR;
 		}	
 	}
 	
 	/* Check if the operand is a valid register for direct register mode */
-	if (is_register(operand) == SUCCESS)
-		return 3;
+	if (operand->type == TOKEN_REGISTER)
+		return MODE_REGISTER;
 		
 	/* If the operand is a valid symbol, it's in direct mode 
 	This check is performed last because a register name can be a valid label name. */
-	if (is_valid_symbol(operand) == SUCCESS)
-		return 1;
+	if (is_symbol_token(operand))
+		return MODE_DIRECT;
 	
 	
 	/* If no valid addressing mode is found, return an error */
-	printf("Error in line number %d: Addressing method does not exist\n", line_num_m);	
+	report(&ctx->diagnostics, "Error in line number %d: Addressing method does not exist\n", ctx->line_num_m);	
 	return ERROR;
 }
 
 
 
-char *operand_encoding(char *operand, int addressing_mode, int is_target_op)
+int operand_encoding(const Token *operand, int addressing_mode, int is_target_op, AssemblyContext *ctx)
 {
-	char * copy_operand;
-	
 	switch (addressing_mode) {
-		case 0:
-			return immediate_addressing(operand);
-		case 1:
-			copy_operand = (char *)malloc(sizeof(operand));
-			if (!copy_operand)
-			{
-				printf("Allocation failure\n");
-				exit(1);
-			}
-			strcpy(copy_operand, operand);
-			
-			return copy_operand;/* The copy of the label name is returned so that it can be replaced with this label address in a second pass */
-		case 2:
-			return register_addressing(operand+1, is_target_op);/* +1 because the first character is '*' which represents the indirect register addressing mode */
-		case 3:
-			return register_addressing(operand, is_target_op);
+		case MODE_IMMEDIATE:
+			return immediate_addressing(operand, ctx);
+		case MODE_DIRECT:
+			return 0;/* The label address is not known yet, the word is completed in the second pass */
+		case MODE_INDIRECT_REGISTER:
+		case MODE_REGISTER:
+			return register_addressing(operand->value, is_target_op);/* The lexer keeps the register number of the operand, with or without '*' */
 	}
 
-	return NULL;
+	return ERROR;
 }
 
 
 
-char *immediate_addressing(char *operand)
+int immediate_addressing(const Token *operand, AssemblyContext *ctx)
 {
-	char *code_word, *num_in_binary;
 	int num;
 	
 	/* Ensure the number is a valid integer */
-	if (strchr(operand + 1, '.') != NULL) 
+	if (memchr(operand->start + 1, '.', operand->length - 1) != NULL) 
 	{
-		printf("Error in line number %d:  Invalid number, not an integer number\n", line_num_m);
-		return NULL;
+		report(&ctx->diagnostics, "Error in line number %d:  Invalid number, not an integer number\n", ctx->line_num_m);
+		return ERROR;
 	}
-	/*if (num != (int)num)*/
 	
-	num = atoi(operand+1);/* Convert the operand (excluding the '#') to an integer */
+	/* Convert the operand (excluding the '#') to an integer. The operand is not null-terminated, but atoi stops 
+	   at its end anyway, unless the '#' stands alone and atoi would skip the white characters after it */
+	num = operand->length > 1 ? atoi(operand->start + 1) : 0;
 	
 	/* Check if the number is within the valid range */
 	if (is_valid_number(num, NUMERIC_OP_LEN) == ERROR)
 	{
-		printf("Error in line number %d:  Invalid number, out of range\n", line_num_m);
-		return NULL;
-	}
-	
-	
-	
-	/* Allocate memory for the code word (16 characters) */
-	code_word = (char *)malloc(CODE_WORD_LEN * sizeof(char));
-	if (!code_word)
-	{
-		printf("Allocation failure\n");
-		exit(1);
-	}
-	
-	/* Convert the immediate number to a binary string (12 bits) */
-	num_in_binary = int_to_binary(num, NUMERIC_OP_LEN);
-	/* Copy the immediate number (excluding the '#') into code_word */
-	strcpy(code_word, num_in_binary); 
-	/* Append "100" to the code_word, because in immediate addressing, the value of the A bit is 1, and the other two bits are set to zero */
-	strcat(code_word, "100"); 
-	
-	
-	free(num_in_binary);	
-	 return code_word;
-}
-
-
-
-char *register_addressing(char *reg, int is_target_op)
-{
-	int reg_num = atoi(reg+1);/* Convert the register number from string to integer, +1 to skip the 'r' and get to the register number*/
-	char *reg_in_binary, *code_word;
-	
-	/* Allocate memory for the code word (16 characters) */
-	code_word = (char *)malloc(CODE_WORD_LEN * sizeof(char));
-	if (!code_word)
-	{
-		printf("Allocation failure\n");
-		exit(1);
-	}
-	
-	/* Convert the register number to a binary string (3 bits) */
-	reg_in_binary = int_to_binary(reg_num, REG_BIT_LENGTH);
-
-	/* If the operand is a target operand, the additional information word of the command will contain in bits 3-5 the number of the register that is used as a pointer. */
-	if (is_target_op)
-	{
-		strcpy(code_word, "000000000");
-		strcat(code_word, reg_in_binary);
-	}
-	/* If the register is a source operand (= not a target operand), the register number will be encoded in bits 6-8 of the additional data word */
-	else
-	{
-		strcpy(code_word, "000000");
-		strcat(code_word, reg_in_binary);
-		strcat(code_word, "000");
+		report(&ctx->diagnostics, "Error in line number %d:  Invalid number, out of range\n", ctx->line_num_m);
+		return ERROR;
 	}
-	/* Append "100" to the code_word, because in register addressing, the value of the A bit is 1, and the other two bits are set to zero */
-	strcat(code_word, "100");
 	
-	
-	free(reg_in_binary);	
-	return code_word;
-}
-
-
-
-void delete_code_node(void *c)
-{
-	CodeNode *data_code_node = (CodeNode *)c;
-	free(data_code_node -> code_word);
-	free(data_code_node);
+	/* The immediate number (12 bits, 2's complement) is encoded in bits 3-14, 
+	   and in immediate addressing the value of the A bit is 1, and the other two bits are set to zero */
+	return ((num & OPERAND_MASK) << ARE_BITS) | ARE_ABSOLUTE;
 }
 
 
 
-void delete_symbol_node(void *s)
+int register_addressing(int reg_num, int is_target_op)
 {
-	SymbolNode *data_symbol_node = (SymbolNode *)s;
-	free(data_symbol_node -> name);
-	free(data_symbol_node);
+	/* If the operand is a target operand, the additional information word of the command will contain in bits 3-5 the number of the register that is used as a pointer.
+	   If the register is a source operand (= not a target operand), the register number will be encoded in bits 6-8 of the additional data word.
+	   In register addressing, the value of the A bit is 1, and the other two bits are set to zero */
+	return register_words[is_target_op != 0][reg_num];
 }
-
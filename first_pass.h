@@ -2,38 +2,31 @@
 #define FIRST_PASS_H
 
 #include "linked_list.h"
+#include "symbol_table.h"
+#include "context.h"
+#include "arena.h"
+#include "lexer.h"
+#include <stdint.h>
 
 #define MEMORY_START_ADDRESS 100
 #define NUM_ADDRESSING_MODES 4
 #define REG_LENGTH 2 
 #define REG_BIT_LENGTH 3
 #define NUMERIC_OP_LEN 12
-#define TEMP_ENTRY_ADDRESS -1
 
-
-typedef struct {
-	char *code_word; 
-	int adress;
-	int line_num;   
-} CodeNode;
-
-
-typedef struct {
-	char *name;
-	int adress;
-	int before_data;
-	int is_entry;
-	int is_extern;
-	int line_num;
-} SymbolNode;
-
-
-typedef struct {
-	char* name; /* Instruction name (e.g., "mov", "add"). */
-	int num_operands; /* Number of operands required. */
-	int source_methods[4]; /* Valid addressing modes for the source operand (0 = not allowed, 1 = allowed). */
-	int target_methods[4]; /* Valid addressing modes for the target operand (0 = not allowed, 1 = allowed). */
-} Instruction;
+/* Layout of a 15-bit code word */
+#define WORD_MASK 0x7FFF /* All 15 bits of a code word */
+#define OPERAND_MASK 0xFFF /* 12 bits of an immediate number or an address, in bits 3-14 */
+#define ARE_BITS 3 /* The ARE field takes bits 0-2 */
+#define ARE_ABSOLUTE 4 /* A = 1 */
+#define ARE_RELOCATABLE 2 /* R = 1 */
+#define ARE_EXTERNAL 1 /* E = 1 */
+#define OPCODE_SHIFT 11 /* The operation code takes bits 11-14 of the first word */
+#define SOURCE_MODE_SHIFT 7 /* The addressing mode of the source operand takes bits 7-10 of the first word */
+#define TARGET_MODE_SHIFT 3 /* The addressing mode of the target operand takes bits 3-6 of the first word */
+#define SOURCE_REG_SHIFT 6 /* A source register number takes bits 6-8 of an additional word */
+#define TARGET_REG_SHIFT 3 /* A target register number takes bits 3-5 of an additional word */
+#define NO_CODE_WORD -2 /* Marks an additional code word that is not needed (differs from ERROR) */
 
 
 
@@ -41,7 +34,7 @@ typedef struct {
 /**
  * Analyzes and processes an assembly language source file in the first pass of assembly.
  *
- * This function reads an assembly code file line by line and performs initial analysis to
+ * This function goes over the expanded source of the context (the file after the macros are spread) line by line, in place, and performs initial analysis to
  * identify labels, directives, and instructions. It handles the creation of symbol nodes,
  * data encoding, and instruction encoding based on the content of each line.
  *
@@ -50,64 +43,44 @@ typedef struct {
  * - Reserved words used as labels
  * - Invalid or misplaced directives
  *
- * The analysis updates the symbol list, data list, and instruction list accordingly.
+ * The analysis updates the symbol table, data image, and code image of the context accordingly.
+ * Duplicate labels and conflicts between entry and extern labels are detected as the labels are added to the symbol table.
  *
- * @param name_file The name of the assembly source file (excluding extension) to be analyzed.
- * @param head_symbols_list A pointer to the head of the linked list where symbol nodes will be added.
- * @param head_data_list A pointer to the head of the linked list where data nodes will be added.
- * @param head_instructions_list A pointer to the head of the linked list where instruction nodes will be added.
+ * @param ctx The assembly context of the file, holding the expanded source.
  *
  * @return An integer indicating whether errors were encountered during the analysis.
  *         - 0 if no errors were found.
  *         - 1 if errors were encountered.
  */
-int first_pass_analyze(char *name_file, node **head_symbols_list, node **head_data_list, node **head_instructions_list);
-
-
-
-/**
- * Creates a new symbol node and adds it to the linked list.
- *
- * This function allocates memory for a new symbol node, initializes it with the provided values,
- * and adds it to the end of the linked list. If memory allocation fails, the function prints an 
- * error message and exits the program.
- *
- * @param name The name of the symbol.
- * @param adress The address associated with the symbol.
- * @param before_data Indicates whether the symbol appears before the data section (1 if true, 0 if false).
- * @param is_entry Indicates whether the symbol is marked as an entry (1 if true, 0 if false).
- * @param is_extern Indicates whether the symbol is marked as external (1 if true, 0 if false).
- * @param head A pointer to the head of the linked list where the symbol node will be added.
- */
-void crate_symbol_node(char *name, int adress, int before_data, int is_entry, int is_extern, node **head);
+int first_pass_analyze(AssemblyContext *ctx);
 
 
 
 /**
- * Encodes data from a given line based on its type and updates the data list and symbols list.
+ * Encodes data from a given line based on its type and updates the data image and the symbol table.
  *
  * This function processes a line of assembly code, extracts data or symbols based on the type specified 
  * (e.g., "data", "string", "entry", "extern"), validates the content, and encodes it into the appropriate format. 
- * For "data" and "string" types, binary data nodes are created and added to the data list. For "entry" and "extern" types, 
- * symbol nodes are created and added to the symbols list. The function also updates the data counter (DC) as new data nodes are added.
+ * For "data" and "string" types, data words are added to the data image. For "entry" and "extern" types, 
+ * the symbols are added to the symbol table. The function also advances the data counter (DC) of the context as new data nodes are added.
  *
  * The function performs the following tasks:
  * - Skips over any whitespace or irrelevant characters.
  * - Validates numbers for "data" type to ensure they are whole numbers within the correct range.
- * - Converts numbers or string characters to binary format and adds them to the data list.
- * - Creates and adds symbol nodes for "entry" and "extern" types.
+ * - Converts numbers or string characters to code words and adds them to the data image.
+ * - Adds the symbols of "entry" and "extern" types to the symbol table.
  * - Ensures proper formatting and syntax, returning an error if invalid data or strings are encountered.
  *
+ * An unknown directive is reported as an error.
+ *
  * @param line The line of assembly code to be processed.
  * @param start_index A pointer to the current index in the line where parsing should begin.
- * @param data_type The type of data or directive (e.g., "data", "string", "entry", "extern").
- * @param DC The Data Counter, tracking the address for the data section.
- * @param head_data_list A pointer to the head of the data list for storing encoded data.
- * @param head_symbols_list A pointer to the head of the symbols list for storing symbols.
+ * @param data_type The directive token (e.g., ".data", ".string", ".entry", ".extern").
+ * @param ctx The assembly context, its data image stores the encoded data and its symbol table stores the "entry" and "extern" symbols.
  *
- * @return The updated Data Counter (DC) after processing the line.
+ * @return SUCCESS if the line was encoded, or `ERROR` if an error occurs.
  */
-int encoding_data(char *line, int *start, char *data_type, int DC, node **head_data_list, node **head_symbols_list);
+int encoding_data(const char *line, int *start, const Token *data_type, AssemblyContext *ctx);
 
 
 
@@ -123,22 +96,43 @@ int encoding_data(char *line, int *start, char *data_type, int DC, node **head_d
  *                    This value is updated to point to the character following the number.
  * @return The extracted integer.
  */
-int extract_number(char *line, int *start_index);
+int extract_number(const char *line, int *start_index);
 
 
 
 /**
- * Creates a new code node (for data or instruction) and adds it to the linked list.
+ * Adds a word to the end of the data image of the context, and advances the data counter (DC).
+ * With bounded memory, the word is appended to the staged data instead.
  *
- * This function allocates memory for a new code node, initializes it with the provided values,
- * and adds it to the end of the linked list. If memory allocation fails, the function prints an
- * error message and exits the program.
+ * @param code_word The data word (15 bits).
+ * @param ctx The assembly context.
+ */
+void add_data_word(uint16_t code_word, AssemblyContext *ctx);
+
+
+
+/**
+ * Adds a word to the end of the code image of the context, and advances the instruction counter (IC).
+ *
+ * @param code_word The instruction word (15 bits).
+ * @param label The label operand whose address completes the code word in the second pass, or NULL. 
+ *              For a label, a fixup of the word is added to the context.
+ *              With bounded memory, the word is written to the staged code instead, and a fixup is added only
+ *              if the label is neither external nor defined on an instruction line yet.
+ * @param ctx The assembly context.
+ */
+void add_instruction_word(uint16_t code_word, const Token *label, AssemblyContext *ctx);
+
+
+
+/**
+ * With bounded memory, overwrites an instruction word in the staged code, for a word that waited for a label.
  *
- * @param code_word The code word (data or instruction) to be stored in the node.
- * @param adress The address associated with the code word.
- * @param head A pointer to the head of the linked list where the code node will be added.
+ * @param ctx The assembly context.
+ * @param word The index of the word (its address is MEMORY_START_ADDRESS + word).
+ * @param code_word The complete instruction word (15 bits).
  */
-void crate_data_or_instruction_node(char *code_word, int adress, node **head);
+void complete_staged_word(AssemblyContext *ctx, int word, uint16_t code_word);
 
 
 
@@ -147,34 +141,15 @@ void crate_data_or_instruction_node(char *code_word, int adress, node **head);
  *
  * This function processes a line of assembly code, extracts the operation name and its operands,
  * determines the addressing modes, validates them, and generates the corresponding machine code
- * words. The machine code words are then added to the instruction list.
+ * words. The machine code words are then added to the code image, and the instruction counter (IC) of the context is advanced.
  *
  * @param line The line of assembly code to be encoded.
  * @param start_index A pointer to the index in the line where encoding should start.
- * @param IC The current instruction counter.
- * @param head_instructions_list A pointer to the head of the list where the encoded instructions will be stored.
+ * @param ctx The assembly context, its code image stores the encoded instructions.
  *
- * @return The updated instruction counter (IC) after encoding the instruction, or `ERROR` if an error occurs.
+ * @return SUCCESS if the instruction was encoded, or `ERROR` if an error occurs.
  */
-int encoding_instructions(char *line, int *start_index, int IC, node **head_instructions_list);
-
-
-
-/**
- * Retrieves information about the addressing methods for a given instruction.
- *
- * This function populates the source and destination addressing methods for a specific instruction
- * from a predefined table. The table defines the legal addressing methods for each instruction's
- * source and destination operands. The index parameter is expected to be the index obtained from
- * the `find_op_name` function. The `op_names_table` and `instructions_table` are synchronized,
- * meaning each index in both arrays corresponds to the same operation.
- *
- * @param index The index of the instruction in the table, obtained from `find_op_name`.
- * @param source_methods An array to be populated with the legal addressing methods for the source operand.
- * @param dest_methods An array to be populated with the legal addressing methods for the destination operand.
- * @return The number of operands for the instruction.
- */
-int information_operation(int index, int source_methods[], int dest_methods[]);
+int encoding_instructions(const char *line, int *start_index, AssemblyContext *ctx);
 
 
 
@@ -183,17 +158,18 @@ int information_operation(int index, int source_methods[], int dest_methods[]);
  *
  * This function extracts an operand from the given line, checks its addressing mode,
  * and validates if it matches the allowed addressing methods for the operation.
- * If the operand is invalid or missing, the function will print an appropriate error
+ * If the operand is invalid or missing, the function will report an appropriate error
  * message and return `ERROR`.
  *
  * @param line The line of assembly code being processed.
  * @param start_index A pointer to the current index in the line, updated after extraction.
- * @param operand A pointer to a char pointer where the extracted operand will be stored.
- * @param addressing_methods An array indicating the valid addressing methods for the operation.
+ * @param operand The token where the extracted operand will be stored, it points into the line.
+ * @param legal_modes The mask of the legal addressing modes of the operand (MODE_..._BIT), from the operation table.
+ * @param ctx The assembly context, (used for error messages).
  *
  * @return The addressing mode of the operand if successful, or `ERROR` if an error occurs.
  */
-int handle_operand(char *line, int *start_index, char **operand, int adressing_methods[]);
+int handle_operand(const char *line, int *start_index, Token *operand, int legal_modes, AssemblyContext *ctx);
 
 
 
@@ -206,19 +182,20 @@ int handle_operand(char *line, int *start_index, char **operand, int adressing_m
  * - Direct register mode (3) if the operand is a valid register.
  * - Direct mode (1) if the operand is a valid symbol (label).
  * 
- * If the operand is invalid, the function prints an error message and returns `ERROR`.
+ * If the operand is invalid, the function reports an error message and returns `ERROR`.
  *
  * @param operand The operand whose addressing mode is to be determined.
+ * @param ctx The assembly context, (used for error messages).
  * @return The addressing mode (0, 1, 2, 3), or `ERROR` if invalid.
  */
-int find_addressing_mode(char *operand);
+int find_addressing_mode(const Token *operand, AssemblyContext *ctx);
 
 
 
 /**
  * Returns the code word of the operand based on the specified addressing mode.
  *
- * @param operand A string representing the operand to be processed.
+ * @param operand The token of the operand to be processed.
  * @param addressing_mode An integer representing the addressing mode of the operand:
  *                        - 0: Immediate addressing mode (the operand is treated as an immediate value).
  *                        - 1: Direct addressing mode (the operand is treated as a direct address).
@@ -226,62 +203,39 @@ int find_addressing_mode(char *operand);
  *                        - 3: Direct register addressing mode (the operand is treated as a direct register address).
  * @param is_target_op An integer flag indicating whether the operand is a target operand.
  *                     This flag is used specifically in register addressing modes.
- * @return A string representing the additional code word of the operand based on the addressing mode.
+ * @param ctx The assembly context, (used for error messages).
+ * @return The additional code word of the operand based on the addressing mode, or `ERROR` if the operand is invalid.
+ *         In direct addressing mode the word is 0, it is completed with the label address in the second pass.
 */
-char *operand_encoding(char *operand, int addressing_mode, int is_target_op);
+int operand_encoding(const Token *operand, int addressing_mode, int is_target_op, AssemblyContext *ctx);
 
 
 
 /**
  * Processes an operand in immediate addressing mode.
  *
- * @param operand A string representing the operand to be processed.
+ * @param operand The token of the operand to be processed.
  *                The operand starts with '#' followed by the immediate number.
- * @return A string representing the code word generated for the immediate operand.
- *         The code word includes the binary representation of the immediate number and a suffix "100".
- *         - NULL if immediate number is invalid or memory allocation fails.
+ * @param ctx The assembly context, (used for error messages).
+ * @return The code word generated for the immediate operand.
+ *         The code word includes the immediate number in bits 3-14 and the ARE bits "100".
+ *         - `ERROR` if immediate number is invalid.
  */
-char *immediate_addressing(char *operand);
+int immediate_addressing(const Token *operand, AssemblyContext *ctx);
 
 
 
 /**
  * Processes an operand in register direct or indirect addressing mode.
  *
- * @param reg A string representing the register operand.
- *            The operand should be a number representing the register.
+ * @param reg_num The number of the register (0 - 7).
  * @param is_target_op An integer flag indicating whether the operand is a target operand.
  *                     If the operand is a target operand, it affects the code word format.
- * @return A string representing the code word generated for the register operand.
- *         The code word includes the binary representation of the register number and additional bits
- *         indicating the addressing mode.
- *         - NULL if memory allocation fails.
- */
-char *register_addressing(char *reg, int is_target_op);
-
-
-
-/**
- * Deletes memory allocated for a CodeNode structure.
- * 
- * This function frees the memory allocated for the code_word of the CodeNode
- * structure and then frees the CodeNode structure itself.
- * 
- * @param c A pointer to the CodeNode structure to be deleted.
- */
-void delete_code_node(void *c);
-
-
-
-/**
- * Deletes memory allocated for a SymbolNode structure.
- * 
- * This function frees the memory allocated for the naame of the SymbolNode
- * structure and then frees the SymbolNode structure itself.
- * 
- * @param s A pointer to the SymbolNode structure to be deleted.
+ * @return The code word generated for the register operand, from a precomputed table.
+ *         The code word includes the register number (bits 3-5 for a target operand, bits 6-8 for a source operand)
+ *         and the ARE bits "100".
  */
-void delete_symbol_node(void *s);
+int register_addressing(int reg_num, int is_target_op);
 
 
 
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "isa.h"
+
+
+/*
+ * Generates a valid assembly source for benchmarking the assembler, and writes it to the standard output (or to a file with -o).
+ * The size and the shape of the source are set by the options below, each followed by a number, e.g.
+ *
+ *     gen_source --lines 100000 --labels 5000 --forward 80 -o big.as
+ *
+ * The source has, in this order: the extern and entry declarations, the macro definitions, the instruction lines
+ * (some of them labeled, and some of them replaced by macro calls), and the data and string lines (each one labeled).
+ * The same options and seed always give the same source.
+ */
+
+
+#define MAX_DATA_NUMBERS 6 /* The largest number of numbers in a generated '.data' line */
+#define MAX_STRING_CHARS 40 /* The longest generated string (of letters, the only characters a string can have) */
+#define MIN_IMMEDIATE -2048 /* The range of an immediate number (12 bits) */
+#define MAX_IMMEDIATE 2047
+#define MIN_DATA -16384 /* The range of a data number (15 bits) */
+#define MAX_DATA 16383
+
+
+/* The parameters of the generated source */
+typedef struct {
+	long lines; /* The number of instruction lines, including the macro calls */
+	long labels; /* The number of labeled instruction lines */
+	long forward; /* The percentage of label operands that refer to a label defined further in the source */
+	long macros; /* The number of macros */
+	long macro_lines; /* The number of lines in the body of every macro */
+	long macro_calls; /* The number of instruction lines that are replaced by a macro call */
+	long data_lines; /* The number of '.data' lines */
+	long string_lines; /* The number of '.string' lines */
+	long externs; /* The number of extern labels */
+	long entries; /* The number of entry labels (at most the number of labels) */
+	long extern_refs; /* The percentage of label operands that refer to an extern label */
+	long seed;
+} GeneratorOptions;
+
+
+/* A command line option, with the field it sets and the largest value it accepts */
+typedef struct {
+	const char *name;
+	long *value;
+	long max;
+} GeneratorParam;
+
+
+/* The operations, as the generator needs them */
+typedef struct {
+	const char *name;
+	int num_operands;
+	int source_modes;
+	int target_modes;
+} GeneratorOperation;
+
+#define GENERATOR_OPERATION(name, code, operands, source_modes, target_modes) {name, operands, source_modes, target_modes},
+static const GeneratorOperation operations[NUM_OP_NAMES] = {
+	ISA_OPERATIONS(GENERATOR_OPERATION)
+};
+#undef GENERATOR_OPERATION
+
+
+static unsigned long random_state;
+
+
+
+/* xorshift, so that the source does not depend on the rand() of the library */
+static long random_below(long n)
+{
+	random_state ^= (random_state << 13) & 0xFFFFFFFFUL;
+	random_state ^= random_state >> 17;
+	random_state ^= (random_state << 5) & 0xFFFFFFFFUL;
+
+	return n > 0 ? (long)(random_state % (unsigned long)n) : 0;
+}
+
+
+
+/* Returns a random number between min and max (including both) */
+static long random_between(long min, long max)
+{
+	return min + random_below(max - min + 1);
+}
+
+
+
+/* Writes a label operand of an instruction line, `defined` is the number of instruction labels up to the line */
+static void write_label_operand(FILE *out, const GeneratorOptions *options, long defined)
+{
+	long later = options->labels - defined + options->data_lines + options->string_lines;
+	long choice;
+
+	if (options->externs > 0 && (random_below(100) < options->extern_refs || (defined == 0 && later == 0)))
+	{
+		fprintf(out, "X%ld", random_below(options->externs));
+		return;
+	}
+
+	/* A forward reference is to a label of a later instruction line or of a data line, a backward one is to a label already defined */
+	if (later > 0 && (defined == 0 || random_below(100) < options->forward))
+	{
+		choice = random_below(later);
+		if (choice < options->labels - defined)
+			fprintf(out, "L%ld", defined + choice);
+		else if ((choice -= options->labels - defined) < options->data_lines)
+			fprintf(out, "D%ld", choice);
+		else
+			fprintf(out, "S%ld", choice - options->data_lines);
+	}
+	else
+		fprintf(out, "L%ld", random_below(defined));
+}
+
+
+
+/* Writes an operand in one of the legal modes of the mask (a label only if `use_labels`) */
+static void write_operand(FILE *out, int modes, int use_labels, const GeneratorOptions *options, long defined)
+{
+	int mode;
+
+	if (!use_labels)
+		modes &= ~MODE_DIRECT_BIT;
+
+	/* Pick one of the legal modes */
+	do
+		mode = (int)random_below(4);
+	while (!(modes & (1 << mode)));
+
+	switch (mode)
+	{
+		case MODE_IMMEDIATE:
+			fprintf(out, "#%ld", random_between(MIN_IMMEDIATE, MAX_IMMEDIATE));
+			break;
+		case MODE_DIRECT:
+			write_label_operand(out, options, defined);
+			break;
+		case MODE_INDIRECT_REGISTER:
+			fprintf(out, "*r%ld", random_below(NUM_REGISTERS));
+			break;
+		default:
+			fprintf(out, "r%ld", random_below(NUM_REGISTERS));
+	}
+}
+
+
+
+/* Writes an instruction with random operands. Label operands are used only if `use_labels` (not inside macros) */
+static void write_instruction(FILE *out, int use_labels, const GeneratorOptions *options, long defined)
+{
+	const GeneratorOperation *operation;
+
+	/* 'lea' needs a label, so it is used only where labels are */
+	do
+		operation = &operations[random_below(NUM_OP_NAMES)];
+	while (!use_labels && operation->source_modes == MODE_DIRECT_BIT);
+
+	fprintf(out, "%s", operation->name);
+
+	if (operation->num_operands == 2)
+	{
+		fprintf(out, " ");
+		write_operand(out, operation->source_modes, use_labels, options, defined);
+		fprintf(out, ", ");
+		write_operand(out, operation->target_modes, use_labels, options, defined);
+	}
+	else if (operation->num_operands == 1)
+	{
+		fprintf(out, " ");
+		write_operand(out, operation->target_modes, use_labels, options, defined);
+	}
+
+	fprintf(out, "\n");
+}
+
+
+
+static void generate_source(FILE *out, const GeneratorOptions *options)
+{
+	long i, j, count, defined = 0, calls = 0;
+	int use_labels = options->labels + options->data_lines + options->string_lines + options->externs > 0;
+
+	/* The options are written in comment lines, a line of the source is at most 80 characters */
+	fprintf(out, "; Generated by gen_source --lines %ld --labels %ld --forward %ld\n", options->lines, options->labels, options->forward);
+	fprintf(out, "; --macros %ld --macro-lines %ld --macro-calls %ld\n", options->macros, options->macro_lines, options->macro_calls);
+	fprintf(out, "; --data %ld --strings %ld --externs %ld --entries %ld\n", options->data_lines, options->string_lines, options->externs, options->entries);
+	fprintf(out, "; --extern-refs %ld --seed %ld\n\n", options->extern_refs, options->seed);
+
+	for (i = 0; i < options->externs; i++)
+		fprintf(out, ".extern X%ld\n", i);
+
+	/* The entry labels are spread over the labels */
+	for (i = 0; i < options->entries; i++)
+		fprintf(out, ".entry L%ld\n", i * options->labels / options->entries);
+
+
+	for (i = 0; i < options->macros; i++)
+	{
+		fprintf(out, "macr M%ld\n", i);
+		for (j = 0; j < options->macro_lines; j++)
+			write_instruction(out, 0, options, 0);
+		fprintf(out, "endmacr\n");
+	}
+
+
+	/* The labels and the macro calls are spread over the instruction lines */
+	for (i = 0; i < options->lines; i++)
+	{
+		if (defined < options->labels && i == defined * options->lines / options->labels)
+			fprintf(out, "L%ld: ", defined++);
+		else if (calls < options->macro_calls && i >= calls * options->lines / options->macro_calls)
+		{
+			fprintf(out, "M%ld\n", calls++ % options->macros);
+			continue;
+		}
+
+		write_instruction(out, use_labels, options, defined);
+	}
+
+
+	for (i = 0; i < options->data_lines; i++)
+	{
+		fprintf(out, "D%ld: .data ", i);
+
+		count = random_between(1, MAX_DATA_NUMBERS);
+		for (j = 0; j < count; j++)
+			fprintf(out, j == 0 ? "%ld" : ", %ld", random_between(MIN_DATA, MAX_DATA));
+		fprintf(out, "\n");
+	}
+
+	for (i = 0; i < options->string_lines; i++)
+	{
+		fprintf(out, "S%ld: .string \"", i);
+
+		count = random_between(0, MAX_STRING_CHARS);
+		for (j = 0; j < count; j++)
+			fputc("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"[random_below(52)], out);
+		fprintf(out, "\"\n");
+	}
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	GeneratorOptions options;
+	GeneratorParam params[12];
+	FILE *out = stdout;
+	char *end;
+	int i, j, num_params = 0;
+
+	options.lines = 1000;
+	options.labels = -1; /* Default: a tenth of the lines */
+	options.forward = 50;
+	options.macros = 10;
+	options.macro_lines = 4;
+	options.macro_calls = -1; /* Default: a sixteenth of the lines */
+	options.data_lines = -1; /* Default: a tenth of the lines */
+	options.string_lines = -1; /* Default: a twentieth of the lines */
+	options.externs = 10;
+	options.entries = 10;
+	options.extern_refs = 10;
+	options.seed = 1;
+
+#define ADD_PARAM(param_name, field, max_value) \
+	params[num_params].name = param_name; params[num_params].value = &options.field; params[num_params++].max = max_value;
+
+	ADD_PARAM("--lines", lines, 100000000L)
+	ADD_PARAM("--labels", labels, 100000000L)
+	ADD_PARAM("--forward", forward, 100)
+	ADD_PARAM("--macros", macros, 1000000L)
+	ADD_PARAM("--macro-lines", macro_lines, 10000)
+	ADD_PARAM("--macro-calls", macro_calls, 100000000L)
+	ADD_PARAM("--data", data_lines, 100000000L)
+	ADD_PARAM("--strings", string_lines, 100000000L)
+	ADD_PARAM("--externs", externs, 1000000L)
+	ADD_PARAM("--entries", entries, 1000000L)
+	ADD_PARAM("--extern-refs", extern_refs, 100)
+	ADD_PARAM("--seed", seed, 0x7FFFFFFFL)
+#undef ADD_PARAM
+
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+		{
+			if ((out = fopen(argv[++i], "w")) == NULL)
+			{
+				fprintf(stderr, "Error! The file %s cannot be opened for writing\n", argv[i]);
+				return 1;
+			}
+			continue;
+		}
+
+		for (j = 0; j < num_params && strcmp(argv[i], params[j].name) != 0; j++)
+			;
+
+		if (j == num_params || i + 1 == argc)
+		{
+			fprintf(stderr, "Usage: gen_source [-o file] [--lines N] [--labels N] [--forward PERCENT] [--macros N] [--macro-lines N] [--macro-calls N]\n"
+				"                  [--data N] [--strings N] [--externs N] [--entries N] [--extern-refs PERCENT] [--seed N]\n");
+			return 1;
+		}
+
+		*params[j].value = strtol(argv[++i], &end, 10);
+		if (*argv[i] == '\0' || *end != '\0' || *params[j].value < 0 || *params[j].value > params[j].max)
+		{
+			fprintf(stderr, "Error! The option %s expects a number between 0 and %ld\n", params[j].name, params[j].max);
+			return 1;
+		}
+	}
+
+
+	/* The defaults that depend on the number of lines */
+	if (options.labels == -1)
+		options.labels = options.lines / 10;
+	if (options.macro_calls == -1)
+		options.macro_calls = options.lines / 16;
+	if (options.data_lines == -1)
+		options.data_lines = options.lines / 10;
+	if (options.string_lines == -1)
+		options.string_lines = options.lines / 20;
+
+	/* Every label is on its own line, every entry is a different label, and macros can be called only if there are any */
+	if (options.labels > options.lines)
+		options.labels = options.lines;
+	if (options.entries > options.labels)
+		options.entries = options.labels;
+	if (options.macros == 0)
+		options.macro_calls = 0;
+	if (options.macro_calls > options.lines - options.labels)
+		options.macro_calls = options.lines - options.labels;
+
+	random_state = (unsigned long)options.seed * 2654435761UL + 1;
+	random_state &= 0xFFFFFFFFUL;
+	if (random_state == 0)
+		random_state = 1;
+
+	generate_source(out, &options);
+
+	/* A source that was cut short must not be taken for a complete one */
+	if (ferror(out) || (out != stdout && fclose(out) != 0))
+	{
+		fprintf(stderr, "Error! The generated source cannot be written\n");
+		return 1;
+	}
+
+	return 0;
+}
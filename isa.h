@@ -0,0 +1,57 @@
+#ifndef ISA_H
+#define ISA_H
+
+
+#define NUM_REGISTERS 8 /* r0 - r7 */
+
+
+/* The addressing modes */
+#define MODE_IMMEDIATE 0 /* '#' followed by a number */
+#define MODE_DIRECT 1 /* A label */
+#define MODE_INDIRECT_REGISTER 2 /* '*' followed by a register */
+#define MODE_REGISTER 3 /* A register */
+
+
+/* The addressing modes, as bits of a mask of the legal modes of an operand (bit i is addressing mode i).
+   The bit of a mode is also its field in the first word of an instruction, shifted to the place of the operand */
+#define MODE_IMMEDIATE_BIT (1 << MODE_IMMEDIATE)
+#define MODE_DIRECT_BIT (1 << MODE_DIRECT)
+#define MODE_INDIRECT_REGISTER_BIT (1 << MODE_INDIRECT_REGISTER)
+#define MODE_REGISTER_BIT (1 << MODE_REGISTER)
+
+#define MODES_NONE 0 /* The operand does not exist */
+#define MODES_ALL (MODE_IMMEDIATE_BIT | MODE_DIRECT_BIT | MODE_INDIRECT_REGISTER_BIT | MODE_REGISTER_BIT)
+#define MODES_WRITABLE (MODE_DIRECT_BIT | MODE_INDIRECT_REGISTER_BIT | MODE_REGISTER_BIT) /* Anything but an immediate number */
+#define MODES_JUMP (MODE_DIRECT_BIT | MODE_INDIRECT_REGISTER_BIT) /* An address in memory */
+#define MODES_REGISTERS (MODE_INDIRECT_REGISTER_BIT | MODE_REGISTER_BIT) /* The operand is encoded by its register number */
+
+
+/* 
+ * The instruction set of the machine, in one place.
+ * Each X(name, operation code, number of operands, legal source modes, legal target modes) describes an operation,
+ * and every table of operations is built by expanding the list with its own X.
+ * The operations are listed by their operation code, so the index of an operation in a table is its code.
+ */
+#define ISA_OPERATIONS(X) \
+	X("mov", 0, 2, MODES_ALL, MODES_WRITABLE) \
+	X("cmp", 1, 2, MODES_ALL, MODES_ALL) \
+	X("add", 2, 2, MODES_ALL, MODES_WRITABLE) \
+	X("sub", 3, 2, MODES_ALL, MODES_WRITABLE) \
+	X("lea", 4, 2, MODE_DIRECT_BIT, MODES_WRITABLE) \
+	X("clr", 5, 1, MODES_NONE, MODES_WRITABLE) \
+	X("not", 6, 1, MODES_NONE, MODES_WRITABLE) \
+	X("inc", 7, 1, MODES_NONE, MODES_WRITABLE) \
+	X("dec", 8, 1, MODES_NONE, MODES_WRITABLE) \
+	X("jmp", 9, 1, MODES_NONE, MODES_JUMP) \
+	X("bne", 10, 1, MODES_NONE, MODES_JUMP) \
+	X("red", 11, 1, MODES_NONE, MODES_WRITABLE) \
+	X("prn", 12, 1, MODES_NONE, MODES_ALL) \
+	X("jsr", 13, 1, MODES_NONE, MODES_JUMP) \
+	X("rts", 14, 0, MODES_NONE, MODES_NONE) \
+	X("stop", 15, 0, MODES_NONE, MODES_NONE)
+
+#define COUNT_OPERATION(name, code, operands, source_modes, target_modes) + 1
+#define NUM_OP_NAMES (0 ISA_OPERATIONS(COUNT_OPERATION)) /* The number of operations */
+
+
+#endif
@@ -0,0 +1,302 @@
+#include "lexer.h"
+#include "utils_and_checks.h"
+#include <stdio.h>
+#include <string.h>
+
+
+#define S CHAR_SPACE
+#define A (CHAR_ALPHA | CHAR_WORD)
+#define D (CHAR_DIGIT | CHAR_WORD)
+#define W CHAR_WORD
+#define C CHAR_COMMA
+
+/* The class of every character (the characters from 128 up belong to no class) */
+const unsigned char char_class[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, S, 0, S, S, S, 0, 0, /* 00-0F */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 10-1F */
+	S, 0, 0, W, 0, 0, 0, 0, 0, 0, W, 0, C, W, W, 0, /* 20-2F */
+	D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0, /* 30-3F */
+	0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, /* 40-4F */
+	A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, W, /* 50-5F */
+	0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, /* 60-6F */
+	A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0, /* 70-7F */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 80-8F */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 90-9F */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* A0-AF */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* B0-BF */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* C0-CF */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* D0-DF */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* E0-EF */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 /* F0-FF */
+};
+
+#undef S
+#undef A
+#undef D
+#undef W
+#undef C
+
+
+/* 
+ * The reserved words (operation names, directives and registers) are found with a perfect hash:
+ * the hash of a word is its length plus the values of its first, second and last characters in keyword_values,
+ * and the values were chosen so that no two reserved words have the same hash modulo KEYWORD_SLOTS.
+ * So a word is a reserved word only if it is the one word in its slot, which takes one comparison.
+ * The operation names and codes in the table must match ISA_OPERATIONS: the number of operations is checked when
+ * the lexer is compiled, and every name and code is checked by lexer_check_keywords when the assembler starts.
+ */
+typedef struct {
+	const char *name;
+	int length;
+	int type;
+	int value;
+} Keyword;
+
+
+#define NUM_KEYWORD_OPERATIONS 16 /* The number of operation names in keywords */
+
+/* Fails to compile (an array of size -1) when an operation is added to ISA_OPERATIONS or removed from it,
+   until the table of the reserved words is built again */
+typedef char keyword_operations_match_isa[NUM_KEYWORD_OPERATIONS == NUM_OP_NAMES ? 1 : -1];
+
+
+/* The value of every character in the hash, the words are made of word characters, which are all below 128 */
+static const unsigned char keyword_values[128] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 51, 0,
+	0, 43, 7, 59, 45, 3, 57, 47, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 52, 20, 35, 37, 33, 0, 61, 0, 20, 25, 0, 59, 3, 5, 46,
+	9, 0, 14, 18, 4, 50, 22, 0, 0, 31, 0, 0, 0, 0, 0, 0
+};
+
+
+/* The reserved words, each in the slot of its hash */
+static const Keyword keywords[KEYWORD_SLOTS] = {
+	{NULL, 0, TOKEN_NONE, 0},
+	{"add", 3, TOKEN_MNEMONIC, 2},
+	{"r6", 2, TOKEN_REGISTER, 6},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r3", 2, TOKEN_REGISTER, 3},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{".string", 7, TOKEN_DIRECTIVE, DIRECTIVE_STRING},
+	{"mov", 3, TOKEN_MNEMONIC, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r0", 2, TOKEN_REGISTER, 0},
+	{".data", 5, TOKEN_DIRECTIVE, DIRECTIVE_DATA},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"lea", 3, TOKEN_MNEMONIC, 4},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r5", 2, TOKEN_REGISTER, 5},
+	{"red", 3, TOKEN_MNEMONIC, 11},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"sub", 3, TOKEN_MNEMONIC, 3},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r2", 2, TOKEN_REGISTER, 2},
+	{"prn", 3, TOKEN_MNEMONIC, 12},
+	{".extern", 7, TOKEN_DIRECTIVE, DIRECTIVE_EXTERN},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"stop", 4, TOKEN_MNEMONIC, 15},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r1", 2, TOKEN_REGISTER, 1},
+	{"rts", 3, TOKEN_MNEMONIC, 14},
+	{"jmp", 3, TOKEN_MNEMONIC, 9},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r4", 2, TOKEN_REGISTER, 4},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"dec", 3, TOKEN_MNEMONIC, 8},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"r7", 2, TOKEN_REGISTER, 7},
+	{"clr", 3, TOKEN_MNEMONIC, 5},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"cmp", 3, TOKEN_MNEMONIC, 1},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{NULL, 0, TOKEN_NONE, 0},
+	{".entry", 6, TOKEN_DIRECTIVE, DIRECTIVE_ENTRY},
+	{"not", 3, TOKEN_MNEMONIC, 6},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"jsr", 3, TOKEN_MNEMONIC, 13},
+	{"bne", 3, TOKEN_MNEMONIC, 10},
+	{NULL, 0, TOKEN_NONE, 0},
+	{"inc", 3, TOKEN_MNEMONIC, 7}
+};
+
+
+
+/* Returns the reserved word that the characters are, or NULL if they are not a reserved word */
+static const Keyword *find_keyword(const char *str, int len)
+{
+	const Keyword *keyword;
+	
+	if (len < MIN_KEYWORD_LENGTH || len > MAX_KEYWORD_LENGTH)
+		return NULL;
+	
+	keyword = &keywords[(len + keyword_values[(unsigned char)str[0]] + keyword_values[(unsigned char)str[1]] + keyword_values[(unsigned char)str[len - 1]]) & (KEYWORD_SLOTS - 1)];
+	
+	if (keyword->length != len || memcmp(keyword->name, str, len) != 0)
+		return NULL;
+	
+	return keyword;
+}
+
+
+
+/* The operations as they are described in ISA_OPERATIONS, to check the table against */
+#define OPERATION_KEYWORD(name, code, operands, source_modes, target_modes) {name, sizeof(name) - 1, TOKEN_MNEMONIC, code},
+static const Keyword operation_keywords[NUM_OP_NAMES] = { ISA_OPERATIONS(OPERATION_KEYWORD) };
+#undef OPERATION_KEYWORD
+
+
+
+int lexer_check_keywords(void)
+{
+	const Keyword *keyword;
+	int i, count = 0;
+	
+	/* Every operation is found by its name, with its code */
+	for (i = 0; i < NUM_OP_NAMES; i++)
+	{
+		keyword = find_keyword(operation_keywords[i].name, operation_keywords[i].length);
+		if (keyword == NULL || keyword->type != TOKEN_MNEMONIC || keyword->value != operation_keywords[i].value)
+			return ERROR;
+	}
+	
+	/* And the table has no other operations */
+	for (i = 0; i < KEYWORD_SLOTS; i++)
+		if (keywords[i].type == TOKEN_MNEMONIC)
+			count++;
+	
+	return count == NUM_OP_NAMES ? SUCCESS : ERROR;
+}
+
+
+
+/* Classifies a word, `all_alnum` tells whether all of its characters are letters or digits */
+static void classify(Token *token, int all_alnum)
+{
+	const char *str = token->start;
+	int len = token->length;
+	const Keyword *keyword;
+	
+	token->value = 0;
+	
+	switch (str[0])
+	{
+		case '#':
+			token->type = TOKEN_IMMEDIATE;
+			return;
+		case '*':
+			keyword = find_keyword(str + 1, len - 1);
+			if (keyword != NULL && keyword->type == TOKEN_REGISTER)
+			{
+				token->type = TOKEN_INDIRECT_REGISTER;
+				token->value = keyword->value;
+			}
+			else
+				token->type = TOKEN_INVALID;
+			return;
+	}
+	
+	if ((keyword = find_keyword(str, len)) != NULL)
+	{
+		token->type = keyword->type;
+		token->value = keyword->value;
+	}
+	else if (all_alnum && (char_class[(unsigned char)str[0]] & CHAR_ALPHA) && len <= MAX_LEN_SYMBOL)
+		token->type = TOKEN_SYMBOL;
+	else
+		token->type = TOKEN_INVALID; /* Including a word that starts with '.' and is not a directive */
+}
+
+
+
+void lex_word(const char *line, int *index, Token *token)
+{
+	int i = *index, all_alnum = 1;
+	unsigned char char_bits;
+	
+	/* Skip leading white characters */
+	while (char_class[(unsigned char)line[i]] & CHAR_SPACE)
+		i++;
+	
+	token->start = line + i;
+	
+	/* Read the word, and check on the way whether all of its characters are letters or digits */
+	while ((char_bits = char_class[(unsigned char)line[i]]) & CHAR_WORD)
+	{
+		if (!(char_bits & (CHAR_ALPHA | CHAR_DIGIT)))
+			all_alnum = 0;
+		i++;
+	}
+	
+	token->length = (int)(line + i - token->start);
+	token->defines_label = line[i] == ':';
+	
+	if (token->length == 0)
+	{
+		token->type = TOKEN_NONE;
+		token->value = 0;
+	}
+	else
+		classify(token, all_alnum);
+	
+	*index = i;
+}
+
+
+
+int skip_commas(const char *line, int *index)
+{
+	int i = *index, comma = 0;
+	
+	while (char_class[(unsigned char)line[i]] & (CHAR_SPACE | CHAR_COMMA))
+	{
+		if (line[i] == ',')
+			comma++;
+		i++;
+	}
+	
+	*index = i;
+	return comma;
+}
+
+
+
+int token_equals(const Token *token, const char *str)
+{
+	return strncmp(token->start, str, token->length) == 0 && str[token->length] == EOS;
+}
+
+
+
+int is_reserved_token(const Token *token)
+{
+	return token->type == TOKEN_DIRECTIVE || token->type == TOKEN_MNEMONIC || token->type == TOKEN_REGISTER;
+}
+
+
+
+int is_symbol_token(const Token *token)
+{
+	return token->type == TOKEN_SYMBOL || token->type == TOKEN_MNEMONIC || token->type == TOKEN_REGISTER;
+}
@@ -0,0 +1,125 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+
+/* Character classes, as bits of the character class table */
+#define CHAR_SPACE 1 /* White characters (as isspace), except for '\n' which ends a line */
+#define CHAR_ALPHA 2 /* Letters */
+#define CHAR_DIGIT 4 /* Digits */
+#define CHAR_WORD 8 /* Characters that can be part of a word: letters, digits and # * . - _ */
+#define CHAR_COMMA 16 /* ',' */
+
+
+/* Token types, the classification of a word */
+#define TOKEN_NONE 0 /* There is no word at this position (the line ended, or the next character cannot be part of a word) */
+#define TOKEN_DIRECTIVE 1 /* .data, .string, .entry or .extern, the value is the directive */
+#define TOKEN_MNEMONIC 2 /* An operation name, the value is its index in the operation names table */
+#define TOKEN_REGISTER 3 /* r0 - r7, the value is the register number */
+#define TOKEN_INDIRECT_REGISTER 4 /* *r0 - *r7, the value is the register number */
+#define TOKEN_IMMEDIATE 5 /* A word starting with '#' */
+#define TOKEN_SYMBOL 6 /* A valid label name that is not a reserved word */
+#define TOKEN_INVALID 7 /* Any other word */
+
+
+/* The reserved words */
+#define KEYWORD_SLOTS 64 /* The size of the perfect hash table of the reserved words, a power of 2 */
+#define MIN_KEYWORD_LENGTH 2 /* r0 */
+#define MAX_KEYWORD_LENGTH 7 /* .string, .extern */
+
+
+/* The directives */
+#define DIRECTIVE_DATA 0
+#define DIRECTIVE_STRING 1
+#define DIRECTIVE_ENTRY 2
+#define DIRECTIVE_EXTERN 3
+#define NUM_DIRECTIVES 4
+
+
+/* 
+ * A word of a line: where it starts in the line and its length (it is not copied), and its classification.
+ * Mnemonics and registers have the form of a valid label name as well, so a word can be used as a label
+ * name when its type is TOKEN_SYMBOL, TOKEN_MNEMONIC or TOKEN_REGISTER.
+ */
+typedef struct {
+	const char *start;
+	int length;
+	int type;
+	int value; /* The directive, the operation index or the register number, depending on the type */
+	int defines_label; /* 1 if the word is followed right away by ':' */
+} Token;
+
+
+extern const unsigned char char_class[256];
+
+
+
+/**
+ * Reads the next word of a line and classifies it, without copying it.
+ *
+ * The function skips white characters (but not a '\n' character, which ends the line), reads the longest sequence
+ * of word characters (letters, digits and # * . - _), and classifies it while it is read.
+ * If the next character cannot be part of a word, the token is empty and its type is TOKEN_NONE.
+ *
+ * @param line The line, it ends with a '\n' or a null character.
+ * @param index A pointer to the index in the line to start from, updated to the character after the word.
+ * @param token The token to fill.
+ */
+void lex_word(const char *line, int *index, Token *token);
+
+
+
+/**
+ * Skips white characters and commas, and counts the commas. The '\n' character is not skipped.
+ *
+ * @param line The line.
+ * @param index A pointer to the index in the line to start from, updated to the first character that is not skipped.
+ * @return The number of commas that were skipped.
+ */
+int skip_commas(const char *line, int *index);
+
+
+
+/**
+ * Compares a token with a null-terminated string.
+ *
+ * @param token The token.
+ * @param str The string.
+ * @return 1 if the token is the string, 0 otherwise.
+ */
+int token_equals(const Token *token, const char *str);
+
+
+
+/**
+ * Checks that the operation names in the table of the reserved words match the instruction set (ISA_OPERATIONS in isa.h):
+ * every operation is found by its name with its code, and there are no other operations in the table.
+ * The table is built by hand for its perfect hash, so it is checked once when the assembler starts.
+ *
+ * @return SUCCESS if the table matches the instruction set, ERROR otherwise.
+ */
+int lexer_check_keywords(void);
+
+
+
+/**
+ * Checks if a token is a reserved word: a directive, an operation name or a register name.
+ *
+ * @param token The token.
+ * @return 1 if the token is a reserved word, 0 otherwise.
+ */
+int is_reserved_token(const Token *token);
+
+
+
+/**
+ * Checks if a token has the form of a valid label name: it begins with a letter, followed by letters and/or digits,
+ * and its length is at most MAX_LEN_SYMBOL.
+ *
+ * @param token The token.
+ * @return 1 if the token is a valid label name, 0 otherwise.
+ */
+int is_symbol_token(const Token *token);
+
+
+
+#endif
@@ -1,66 +1,72 @@
 #include "linked_list.h"
+#include "memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 
 
-void add_node_end(node ** head, void * new_data, void(*delete_data)(void *))
+void list_init(List *list)
 {
-	node * temp = *head;
-	if(temp==NULL) /* If the list is empty */
+	list->head = NULL;
+	list->tail = NULL;
+	list->count = 0;
+	list->blocks = NULL;
+}
+
+
+
+void add_node_end(List *list, void * new_data)
+{
+	NodeBlock *block = list->blocks;
+	node *new_node;
+	int capacity;
+	
+	/* If there is no block yet or the current block is full, allocate a new block of twice the size */
+	if (block == NULL || block->used == block->capacity)
 	{
-		*head = (node *)malloc(sizeof(node));
-		if(*head==NULL)
-		{
-			printf("Allocation failure\n");
-			exit(1);
-		}
+		capacity = block ? 2 * block->capacity : LIST_FIRST_BLOCK_NODES;
+		block = (NodeBlock *)memory_alloc(sizeof(NodeBlock) + capacity * sizeof(node), MEMORY_LISTS);
 		
-		(*head)->next = NULL;
-		(*head)->data = new_data;
+		block->capacity = capacity;
+		block->used = 0;
+		block->next = list->blocks;
+		list->blocks = block;
 	}
+	
+	/* The nodes of a block are stored right after its header */
+	new_node = (node *)(block + 1) + block->used++;
+	new_node->data = new_data;
+	new_node->next = NULL;
+	
+	if (list->tail == NULL) /* If the list is empty */
+		list->head = new_node;
 	else
-	{
-		/* Traverse to the end of the list */
-		while(temp->next!=NULL)
-		{
-			temp = (node *)temp->next;
-		}
-		temp->next = (next_type)malloc(sizeof(node));
-		if(temp->next==NULL)
-		{
-			printf("Allocation failure\n");
-			free_list(head, delete_data); /* Clean up the list in case of allocation failure */
-			exit(1);
-		}
-		
-		temp = (node *)temp->next;
-		temp->data = new_data;
-		temp->next = NULL;
-	}
+		list->tail->next = new_node;
 	
-
+	list->tail = new_node;
+	list->count++;
 }
 
 
 
-void free_list(node ** head_ptr, void(*delete_data)(void *))
+void free_list(List *list, void(*delete_data)(void *))
 {
 	node * temp;
-	node * head = *head_ptr;
+	NodeBlock *block, *next_block;
 	
-	/* While there are nodes in the list */
-	while(head!=NULL)
+	/* Delete the data of each node */
+	if (delete_data != NULL)
 	{
-		temp = (node *)head->next; /* Store the next node */
-		delete_data((void *)head->data); /* Free the data in the current node */
-		free(head); /* Free the current node */
-		head = temp;
+		for (temp = list->head; temp != NULL; temp = temp->next)
+			delete_data(temp->data);
 	}
 	
-	*head_ptr = NULL; /* Set the head pointer to NULL, indicating the list is empty */
-
+	/* Free the nodes themselves, a block at a time */
+	for (block = list->blocks; block != NULL; block = next_block)
+	{
+		next_block = block->next;
+		memory_free(block);
+	}
+	
+	list_init(list); /* The list is empty */
 }
-
-
-
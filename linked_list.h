@@ -2,39 +2,67 @@
 #define LINKED_LIST_H
 
 
+#define LIST_FIRST_BLOCK_NODES 32 /* Number of nodes in the first block of a list, each next block doubles it */
+
+
 typedef struct node * next_type;
-typedef struct{
+typedef struct node {
 	void *data;
 	next_type next;
 }node;
 
 
+/* The nodes of a list are carved out of blocks, so that a list of n nodes needs only O(log n) allocations */
+typedef struct NodeBlock {
+	struct NodeBlock *next;
+	int capacity;
+	int used;
+} NodeBlock;
+
+
+/* A list handle that keeps the tail and the number of nodes, so that appending is O(1) */
+typedef struct {
+	node *head;
+	node *tail;
+	int count;
+	NodeBlock *blocks; /* The most recently allocated block comes first */
+} List;
+
+
+
+/**
+ * list_init - Initializes an empty list.
+ * 
+ * @param list Pointer to the list handle.
+ */
+void list_init(List *list);
+
+
+
 /**
  * add_node_end - Adds a new node to the end of the linked list.
  * 
  * This function creates a new node with the provided data and appends it
- * to the end of the linked list. If the list is empty, it initializes the list 
- * with the new node.
+ * to the end of the linked list in constant time, using the tail pointer of the list handle.
  * 
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list handle.
  * @param new_data Pointer to the data to be stored in the new node.
- * @param delete_data Function pointer to a function that deletes the data in a node in case of allocation failure.
  */
-void add_node_end(node ** head, void * new_data, void(*delete_data)(void *));
+void add_node_end(List *list, void * new_data);
 
 
 
 /**
  * free_list - Frees the entire linked list.
  * 
- * This function iterates through the linked list, deletes the data in each node 
- * using the provided delete_data function, and then frees the memory allocated 
- * for each node.
+ * This function deletes the data in each node using the provided delete_data function
+ * (if it is not NULL), and then releases all the nodes at once by freeing their blocks.
+ * The list is left empty and can be used again.
  * 
- * @param head_ptr Pointer to the head pointer of the linked list.
- * @param delete_data Function pointer to a function that deletes the data in a node.
+ * @param list Pointer to the list handle.
+ * @param delete_data Function pointer to a function that deletes the data in a node, or NULL if the data is not owned by the list.
  */
-void free_list(node ** head_ptr, void(*delete_data)(void *));
+void free_list(List *list, void(*delete_data)(void *));
 
 
 
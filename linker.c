@@ -0,0 +1,450 @@
+#define _POSIX_C_SOURCE 200112L /* For the POSIX threads */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "utils_and_checks.h"
+#include "first_pass.h"
+#include "object_file.h"
+#include "output.h"
+#include "memory.h"
+
+
+/*
+ * Links the object files of modules into one image:
+ *
+ *     linker [-j threads] [-o output] [--object=text|binary] module...
+ *
+ * Every module is an object file: module.bin, or module.ob (the suffix may be left out) with its .ent and .ext files.
+ * The instruction sections of the modules are laid out one after the other from MEMORY_START_ADDRESS, in the order
+ * of the command line, and are followed by the data sections in the same order. The linked image is therefore an
+ * object file like the ones of the assembler, written to output.ob (or output.bin), where output is "linked" by default.
+ *
+ * Every relocatable word (ARE = R) is moved with the section that its address is in, and every external word
+ * (ARE = E) gets the address of the entry label that it refers to in its .ext file, which must be an entry of exactly
+ * one module. The entry labels of all the modules are kept in one hash table. The modules are loaded and relocated
+ * by a pool of threads (-j, 0 stands for the number of processors), every module on its own.
+ * The messages are printed in the order of the modules, and nothing is written if there are errors.
+ */
+
+
+#define DEFAULT_OUTPUT "linked"
+#define MODULES_PER_TASK 16 /* The modules that a thread takes at once */
+
+
+typedef struct {
+	const char *file_name;
+	ObjectImage image;
+	int code_base; /* The linked address of the first instruction word of the module */
+	int data_base; /* The linked address of the first data word of the module */
+	Diagnostics diagnostics;
+	int has_errors;
+} Module;
+
+
+/* An entry label, at its linked address */
+typedef struct {
+	const char *name; /* Points into the symbol section of the module */
+	int address;
+	int module;
+} GlobalSymbol;
+
+
+/* The entry labels of all the modules, with an open addressing hash index (linear probing) over them, as in the symbol table */
+typedef struct {
+	GlobalSymbol *symbols;
+	int count;
+	int *slots; /* The index of a symbol + 1, 0 marks an empty slot */
+	int num_slots; /* A power of 2, at least twice the number of symbols */
+} GlobalTable;
+
+
+typedef struct Linker Linker;
+
+struct Linker {
+	Module *modules;
+	int num_modules;
+	GlobalTable globals;
+	ObjectImage linked; /* The linked image, its words are one allocation */
+	int num_threads;
+	void (*task)(Linker *linker, int module); /* The work that the threads do for every module */
+	int next_module; /* The first module that was not taken by a thread yet */
+	pthread_mutex_t lock;
+};
+
+
+
+/* Takes modules and does the task of the linker for them, until all the modules are taken */
+static void *link_worker_main(void *arg)
+{
+	Linker *linker = (Linker *)arg;
+	int i, first;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&linker->lock);
+		first = linker->next_module;
+		linker->next_module += MODULES_PER_TASK;
+		pthread_mutex_unlock(&linker->lock);
+
+		if (first >= linker->num_modules)
+			break;
+
+		for (i = first; i < first + MODULES_PER_TASK && i < linker->num_modules; i++)
+			linker->task(linker, i);
+	}
+
+	return NULL;
+}
+
+
+
+/* Does a task for every module, with the threads of the linker (the calling thread is one of them) */
+static void run_parallel(Linker *linker, void (*task)(Linker *linker, int module))
+{
+	pthread_t *threads = (pthread_t *)memory_alloc(linker->num_threads * sizeof(pthread_t), MEMORY_DRIVER);
+	int i, num_started = 0;
+
+	linker->task = task;
+	linker->next_module = 0;
+
+	for (i = 1; i < linker->num_threads && i * MODULES_PER_TASK < linker->num_modules; i++)
+	{
+		if (pthread_create(&threads[i], NULL, link_worker_main, linker) != 0)
+			break;
+		num_started++;
+	}
+
+	link_worker_main(linker);
+
+	for (i = 1; i <= num_started; i++)
+		pthread_join(threads[i], NULL);
+
+	memory_free(threads);
+}
+
+
+
+static void load_module(Linker *linker, int index)
+{
+	Module *module = &linker->modules[index];
+
+	if (object_load(&module->image, module->file_name, &module->diagnostics) == ERROR)
+		module->has_errors = 1;
+}
+
+
+
+/* Returns the linked address of an address of a module, or ERROR if it is not in one of its sections.
+   An address right after the data section is allowed, (a label at the end of the module) */
+static int link_address(const Module *module, int address)
+{
+	int offset = address - module->image.base_address;
+
+	if (offset >= 0 && offset < module->image.code_count)
+		return module->code_base + offset;
+
+	offset -= module->image.code_count;
+	if (offset >= 0 && offset <= module->image.data_count)
+		return module->data_base + offset;
+
+	return ERROR;
+}
+
+
+
+/* Returns the entry label with a name, or NULL if no module has it */
+static GlobalSymbol *find_global(GlobalTable *globals, const char *name)
+{
+	int slot = (int)(hash_span(name, (int)strlen(name)) & (globals->num_slots - 1));
+
+	while (globals->slots[slot] != 0)
+	{
+		if (strcmp(globals->symbols[globals->slots[slot] - 1].name, name) == 0)
+			return &globals->symbols[globals->slots[slot] - 1];
+		slot = (slot + 1) & (globals->num_slots - 1);
+	}
+
+	return NULL;
+}
+
+
+
+/* Adds the entry labels of all the modules to the global table, in the order of the modules.
+   Returns ERROR if a label is an entry of two modules, or is not inside its module */
+static int build_globals(Linker *linker)
+{
+	GlobalTable *globals = &linker->globals;
+	GlobalSymbol *symbol;
+	ObjectRecord *record;
+	Module *module;
+	int i, j, total = 0, address, slot, error_flag = 0;
+
+	for (i = 0; i < linker->num_modules; i++)
+		total += linker->modules[i].image.num_symbols;
+
+	for (globals->num_slots = SYMBOL_TABLE_INIT_SLOTS; globals->num_slots < 2 * total; globals->num_slots *= 2)
+		;
+	globals->slots = (int *)memory_calloc(globals->num_slots, sizeof(int), MEMORY_SYMBOLS);
+	globals->symbols = (GlobalSymbol *)memory_alloc((total + 1) * sizeof(GlobalSymbol), MEMORY_SYMBOLS);
+	globals->count = 0;
+
+	for (i = 0; i < linker->num_modules; i++)
+	{
+		module = &linker->modules[i];
+
+		for (j = 0; j < module->image.num_symbols; j++)
+		{
+			record = &module->image.symbols[j];
+			address = link_address(module, record->address);
+			symbol = find_global(globals, record->name);
+
+			if (address == ERROR)
+				report(&module->diagnostics, "Error! The entry label %s of %s is at address %d, which is not in the module\n", record->name, module->file_name, record->address);
+			else if (symbol != NULL)
+				report(&module->diagnostics, "Error! The label %s is an entry of both %s and %s\n", record->name, linker->modules[symbol->module].file_name, module->file_name);
+			else
+			{
+				/* The label is new, so the probe ends at an empty slot */
+				for (slot = (int)(hash_span(record->name, (int)strlen(record->name)) & (globals->num_slots - 1)); globals->slots[slot] != 0; slot = (slot + 1) & (globals->num_slots - 1))
+					;
+				symbol = &globals->symbols[globals->count];
+				symbol->name = record->name;
+				symbol->address = address;
+				symbol->module = i;
+				globals->slots[slot] = ++globals->count;
+				continue;
+			}
+
+			module->has_errors = 1;
+			error_flag = 1;
+		}
+	}
+
+	return error_flag ? ERROR : SUCCESS;
+}
+
+
+
+/* Stores a linked address in a word, returns ERROR if it does not fit in the operand field */
+static int patch_word(uint16_t *word, int address)
+{
+	if (address > OPERAND_MASK)
+		return ERROR;
+
+	*word = (uint16_t)((address << ARE_BITS) | ARE_RELOCATABLE);
+	return SUCCESS;
+}
+
+
+
+/* Copies the words of a module into the linked image, moves its relocatable words and resolves its external words */
+static void relocate_module(Linker *linker, int index)
+{
+	Module *module = &linker->modules[index];
+	uint16_t *code = linker->linked.code + (module->code_base - MEMORY_START_ADDRESS);
+	ObjectRecord *reference;
+	GlobalSymbol *symbol;
+	int i, address, offset, num_external = 0;
+
+	memcpy(code, module->image.code, module->image.code_count * sizeof(uint16_t));
+	memcpy(linker->linked.data + (module->data_base - linker->linked.base_address - linker->linked.code_count), module->image.data, module->image.data_count * sizeof(uint16_t));
+
+	for (i = 0; i < module->image.code_count; i++)
+	{
+		if ((code[i] & ((1 << ARE_BITS) - 1)) == ARE_EXTERNAL)
+			num_external++;
+
+		else if ((code[i] & ((1 << ARE_BITS) - 1)) == ARE_RELOCATABLE)
+		{
+			address = link_address(module, code[i] >> ARE_BITS);
+			if (address == ERROR || patch_word(&code[i], address) == ERROR)
+			{
+				report(&module->diagnostics, "Error! The word at address %d of %s refers to address %d, which cannot be linked\n", module->image.base_address + i, module->file_name, code[i] >> ARE_BITS);
+				module->has_errors = 1;
+			}
+		}
+	}
+
+	/* Every external word must be listed in the .ext file, with the label that it refers to */
+	for (i = 0; i < module->image.num_relocations; i++)
+	{
+		reference = &module->image.relocations[i];
+		offset = reference->address - module->image.base_address;
+
+		if (offset < 0 || offset >= module->image.code_count || (module->image.code[offset] & ((1 << ARE_BITS) - 1)) != ARE_EXTERNAL)
+			report(&module->diagnostics, "Error! The reference to %s at address %d of %s is not an external word\n", reference->name, reference->address, module->file_name);
+		else if ((symbol = find_global(&linker->globals, reference->name)) == NULL)
+			report(&module->diagnostics, "Error! The label %s, external in %s, is not an entry of any module\n", reference->name, module->file_name);
+		else if (patch_word(&code[offset], symbol->address) == ERROR)
+			report(&module->diagnostics, "Error! The address %d of the label %s, external in %s, does not fit in a word\n", symbol->address, reference->name, module->file_name);
+		else
+			continue;
+
+		module->has_errors = 1;
+	}
+
+	if (num_external != module->image.num_relocations)
+	{
+		report(&module->diagnostics, "Error! The external words of %s do not match its externals file\n", module->file_name);
+		module->has_errors = 1;
+	}
+}
+
+
+
+/* Lays out the sections of the modules, and allocates the words of the linked image */
+static void lay_out_modules(Linker *linker)
+{
+	int i, address = MEMORY_START_ADDRESS;
+
+	/* The instruction sections first, then the data sections, each in the order of the modules */
+	for (i = 0; i < linker->num_modules; i++)
+	{
+		linker->modules[i].code_base = address;
+		address += linker->modules[i].image.code_count;
+	}
+
+	for (i = 0; i < linker->num_modules; i++)
+	{
+		linker->modules[i].data_base = address;
+		address += linker->modules[i].image.data_count;
+	}
+
+	linker->linked.base_address = MEMORY_START_ADDRESS;
+	linker->linked.code_count = linker->modules[0].data_base - MEMORY_START_ADDRESS;
+	linker->linked.data_count = address - MEMORY_START_ADDRESS - linker->linked.code_count;
+	linker->linked.code = (uint16_t *)memory_alloc((address - MEMORY_START_ADDRESS + 1) * sizeof(uint16_t), MEMORY_CODE);
+	linker->linked.data = linker->linked.code + linker->linked.code_count;
+	linker->linked.owns_words = 1;
+}
+
+
+
+/* Prints the messages of the modules in their order, returns the number of modules with errors */
+static int print_messages(Linker *linker)
+{
+	int i, num_errors = 0;
+
+	for (i = 0; i < linker->num_modules; i++)
+	{
+		diagnostics_flush(&linker->modules[i].diagnostics, stdout);
+		num_errors += linker->modules[i].has_errors;
+	}
+
+	return num_errors;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	Linker linker;
+	TextBuffer out;
+	Diagnostics diagnostics;
+	const char *output = DEFAULT_OUTPUT;
+	int i, format = OBJECT_TEXT, result = SUCCESS;
+
+	output_init();
+	linker.num_threads = 1;
+	linker.num_modules = 0;
+	linker.modules = (Module *)memory_alloc(argc * sizeof(Module), MEMORY_DRIVER);
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+
+		else if (strcmp(argv[i], "--object=text") == 0)
+			format = OBJECT_TEXT;
+
+		else if (strcmp(argv[i], "--object=binary") == 0)
+			format = OBJECT_BINARY;
+
+		else if (strncmp(argv[i], "-j", 2) == 0)
+		{
+			/* The number of threads follows the option, either in the same argument (-j4) or in the next one (-j 4) */
+			linker.num_threads = argv[i][2] != EOS ? parse_num_threads(argv[i] + 2) : i + 1 < argc ? parse_num_threads(argv[++i]) : ERROR;
+			if (linker.num_threads == ERROR)
+			{
+				printf("Error! The option -j expects a number of threads between 0 and %d (0 = all the processors)\n", MAX_THREADS);
+				memory_free(linker.modules);
+				return 1;
+			}
+		}
+
+		else if (argv[i][0] == '-')
+		{
+			printf("Error! Unknown option %s\n", argv[i]);
+			memory_free(linker.modules);
+			return 1;
+		}
+
+		else
+		{
+			linker.modules[linker.num_modules].file_name = argv[i];
+			object_image_init(&linker.modules[linker.num_modules].image);
+			diagnostics_init(&linker.modules[linker.num_modules].diagnostics);
+			linker.modules[linker.num_modules++].has_errors = 0;
+		}
+	}
+
+	if (linker.num_modules == 0)
+	{
+		printf("Usage: linker [-j threads] [-o output] [--object=text|binary] module...\n");
+		memory_free(linker.modules);
+		return 1;
+	}
+
+	pthread_mutex_init(&linker.lock, NULL);
+	object_image_init(&linker.linked);
+	linker.globals.symbols = NULL;
+	linker.globals.slots = NULL;
+
+	/* The modules are loaded together, and are relocated only once all the entry labels are known */
+	run_parallel(&linker, load_module);
+
+	if (print_messages(&linker) > 0)
+		result = ERROR;
+	else
+	{
+		lay_out_modules(&linker);
+
+		if (build_globals(&linker) == SUCCESS)
+			run_parallel(&linker, relocate_module);
+
+		if (print_messages(&linker) > 0)
+			result = ERROR;
+	}
+
+	/* The linked image is written only if all the modules were linked without errors */
+	if (result == SUCCESS)
+	{
+		text_buffer_init(&out);
+		diagnostics_init(&diagnostics);
+
+		if (format == OBJECT_BINARY)
+			object_format_binary(&linker.linked, &out);
+		else
+			object_format_text(&linker.linked, &out);
+		result = write_output_file(output, object_extension(format), out.text, out.length, &diagnostics);
+
+		diagnostics_flush(&diagnostics, stdout);
+		diagnostics_free(&diagnostics);
+		text_buffer_free(&out);
+	}
+
+	for (i = 0; i < linker.num_modules; i++)
+	{
+		object_image_free(&linker.modules[i].image);
+		diagnostics_free(&linker.modules[i].diagnostics);
+	}
+	object_image_free(&linker.linked);
+	memory_free(linker.globals.symbols);
+	memory_free(linker.globals.slots);
+	memory_free(linker.modules);
+	pthread_mutex_destroy(&linker.lock);
+
+	return result == ERROR;
+}
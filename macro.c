@@ -1,214 +1,227 @@
-#include "linked_list.h"
 #include "utils_and_checks.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include "macro.h"
+#include "lexer.h"
+#include "output.h"
+#include "context.h"
+#include "memory.h"
+#include "first_pass.h"
 
 
-int line_num_s = 0; /* Global variable for line number in files with suffix s, (used for error messages). */
+/* Returns the next line of the source in `text` (including its '\n' character), and counts it.
+   The line is parsed in place in the source, only a last line that does not end with a '\n' character is copied into `line`, to null-terminate it.
+   Returns 0 at the end of the source, ERROR if the line is too long (it is reported, and should be skipped), and SUCCESS otherwise. */
+static int next_source_line(AssemblyContext *ctx, char *line, const char **text, int *len)
+{
+	int line_len;
+	
+	if (ctx->line_num_s >= ctx->source.num_lines)
+		return 0;
+	
+	*text = source_line(&ctx->source, ctx->line_num_s, len);
+	ctx->line_num_s++;
+	
+	/* The length of the line without its '\n' character */
+	line_len = (*len > 0 && (*text)[*len - 1] == NEW_LINE) ? *len - 1 : *len;
+	if (line_len > MAX_LINE_CHARS)
+	{
+		report(&ctx->diagnostics, "Error in line number %d: The line is longer than %d characters\n", ctx->line_num_s, MAX_LINE_CHARS);
+		return ERROR;
+	}
+	
+	if (line_len == *len)
+	{
+		memcpy(line, *text, *len);
+		line[*len] = EOS;
+		*text = line;
+	}
+	
+	return SUCCESS;
+}
+
+
+
+/* Hands the expanded source to the first pass and empties it, with bounded memory */
+static void pass_expanded_source(AssemblyContext *ctx)
+{
+	if (first_pass_analyze(ctx))
+		ctx->first_pass_errors = 1;
+	ctx->expanded.length = 0;
+}
+
+
+
+/* Appends lines to the expanded source. With bounded memory it is handed to the first pass in chunks, so that it is never held whole */
+static void append_expanded(AssemblyContext *ctx, const char *text, int len)
+{
+	text_buffer_append(&ctx->expanded, text, len);
+	
+	if (ctx->bounded_memory && ctx->expanded.length >= EXPANDED_CHUNK_SIZE)
+		pass_expanded_source(ctx);
+}
+
 
 
-int macro_analyze(char * name_file, node **head_macro_list)
+int open_source_file(char *name_file, AssemblyContext *ctx)
 {
-	char line[MAX_LEN_LINE], *first_field, *macro_name, *macro_replacement;
-	int i;
-	FILE * fr, *fw;
+	char *full_name_file;
+	int result;
+	
+	if (strcmp(name_file, STREAM_NAME) == 0)
+	{
+		result = source_read_stdin(&ctx->source);
+		if (result == ERROR)
+			report(&ctx->diagnostics, "Error! The standard input cannot be read\n");
+		return result;
+	}
 	
+	full_name_file = generate_full_name(name_file, ".as");
+	result = source_open(&ctx->source, full_name_file);
+	if (result == ERROR)
+		report(&ctx->diagnostics, "Error! The file %s cannot be opened for reading\n", full_name_file);
+	memory_free(full_name_file);
+	
+	return result;
+}
+
 
-	/* Initialize input and output files */
-	init_file(&fr, name_file, ".as", "r");
-	init_file(&fw, name_file, ".am", "w+");
+
+int macro_analyze(AssemblyContext *ctx)
+{
+	char line[MAX_LEN_LINE];
+	const char *text;
+	int i, len, result, has_errors = 0;
+	Token first_field, macro_name;
+	MacroNode *macro;
+	SymbolNode *symbol;
 	
 	
-	/* Read lines from the input file */
-	while (fgets(line,MAX_LEN_LINE,fr))
+	/* Go over the lines of the source */
+	while ((result = next_source_line(ctx, line, &text, &len)) != 0)
 	{
-		line_num_s++;
+		/* A line that is too long is skipped */
+		if (result == ERROR)
+		{
+			has_errors = 1;
+			continue;
+		}
+		
 		i = 0;  /* Reset i for each new line */
-        	first_field = extract_word(line, &i);
+        	lex_word(text, &i, &first_field);
 			
 		/* If the line starts with "macr", handle the macro definition */
-		if (strcmp(first_field, "macr") == 0)
+		if (token_equals(&first_field, "macr"))
 		{
-			macro_name = extract_word(line, &i);
+			lex_word(text, &i, &macro_name);
 		
 			/* Checking that there are no extra characters in the definition line */
-			if (!check_only_whitespace_after_index(line, i))
+			if (check_only_whitespace_after_index(text, i) == ERROR)
 			{
-				printf("Error in line number %d: No additional characters are allowed in the definition line\n", line_num_s);
-				free(macro_name);
-				free(first_field);
+				report(&ctx->diagnostics, "Error in line number %d: No additional characters are allowed in the definition line\n", ctx->line_num_s);
 				return ERROR;
 			}
 				
 			/* Checks if a macro name is a reserved word, if so - the macro name is invalid and this is an error, stop, report the errors and go to the next source file (if any).*/
-			if (is_reserved_word(macro_name) == SUCCESS)
+			if (is_reserved_token(&macro_name))
 			{
-				printf("Error in line number %d: invalid macro name\n", line_num_s);
-				free(macro_name);
-				free(first_field);
+				report(&ctx->diagnostics, "Error in line number %d: invalid macro name\n", ctx->line_num_s);
 				return ERROR;
 			}
-			else
+			
+			/* With bounded memory the labels of the lines before the definition are already in the symbol table,
+			   so a label with the name of the macro is found here rather than in the first pass */
+			if (ctx->bounded_memory)
 			{
-				if (!handle_macro(&fr, macro_name, head_macro_list))
+				pass_expanded_source(ctx);
+				symbol = find_symbol(&ctx->symbols, macro_name.start, macro_name.length);
+				if (symbol != NULL && (symbol->is_defined || symbol->is_extern))
 				{
-					free(macro_name);
-					free(first_field);
-					return ERROR;
+					report(&ctx->diagnostics, "Error in line number %d: Label and macro with the same name - '%.*s'\n", ctx->line_num_s, macro_name.length, macro_name.start);
+					has_errors = 1;
 				}
 			}
-				
-			free(macro_name);
+			
+			if (handle_macro(&macro_name, ctx) == ERROR)
+				return ERROR;
 		}	
-		/* If the line contains a macro name, replace it with the macro content */	
-		else if ((macro_replacement = find_macro(first_field, head_macro_list)) != NULL) 
-			fputs(macro_replacement, fw);
+		/* If the line contains a macro name, replace it with the macro content (in one block) */	
+		else if ((macro = find_macro(first_field.start, first_field.length, &ctx->macros)) != NULL) 
+		{
+			append_expanded(ctx, macro->content, macro->length);
+			ctx->stats.macro_expansions++;
+		}
 		
-		/* Otherwise, write the line as is to the output file */
+		/* Otherwise, copy the line as is to the expanded source */
 		else
-			fputs(line, fw);
-			
-		free(first_field);
+			append_expanded(ctx, text, len);
 	}
 	
-	/* Close the input and output files */
-	fclose(fr);
-	fclose(fw);
-	
-	return SUCCESS;
+	return has_errors ? ERROR : SUCCESS;
 }
 
 
 
-int handle_macro(FILE ** fp, char *macro_name, node **head)
+int handle_macro(const Token *macro_name, AssemblyContext *ctx)
 {
-	char line[MAX_LEN_LINE], *first_field, *macro_content, *ptr;
-	int i, len;
-	
-	/* Initialize the macro content with an empty string */
-	macro_content = (char *)malloc(sizeof(char));
-	if (!macro_content)
-	{
-		printf("Allocation failure\n");
-		exit(1);
-	}
-	*macro_content = EOS;
+	char line[MAX_LEN_LINE];
+	const char *text, *content_start = NULL, *content_end = NULL;
+	int i, len, result, has_errors = 0, definition_line = ctx->line_num_s;
+	Token first_field;
 	
-	/* Read lines until "endmacr" is encountered */
-	while (fgets(line,MAX_LEN_LINE,*fp))
+	/* Read lines until "endmacr" is encountered. The lines of the macro are consecutive in the source,
+	   so the content of the macro is the part of the source between the definition line and the end line */
+	while ((result = next_source_line(ctx, line, &text, &len)) != 0)
 	{
+		if (content_start == NULL)
+			content_start = content_end = text;
+		
+		/* A line that is too long is reported, and the macro is not created */
+		if (result == ERROR)
+		{
+			has_errors = 1;
+			continue;
+		}
+		
 		i = 0; /* Reset i for each new line */
-		first_field = extract_word(line, &i);
+		lex_word(text, &i, &first_field);
 		
-		if (strcmp(first_field, "endmacr") == 0)
+		if (token_equals(&first_field, "endmacr"))
 		{
 			/* Checking that there are no extra characters in the end line */
-			if (!check_only_whitespace_after_index(line, i))
+			if (check_only_whitespace_after_index(text, i) == ERROR)
 			{
-				printf("Error in line number %d: No additional characters are allowed in the end line\n", line_num_s);
-				free(first_field);
-				return ERROR;/* Indicate failure */
+				report(&ctx->diagnostics, "Error in line number %d: No additional characters are allowed in the end line\n", ctx->line_num_s);
+				return ERROR;
 			}
-			create_node(macro_name, macro_content, head);
-			free(macro_content);
-			return SUCCESS; /* Indicate success */
-		}	
-		else
-		{
-			len = strlen(line);
 			
-			/* Reallocate memory to accommodate the new line */
-			ptr = (char *)realloc(macro_content, strlen(macro_content)+(len+1)*sizeof(char));
-			if (!ptr)
-			{
-				free(macro_content);
-				printf("Allocation failure\n");
-				exit(1);/*return 1 in main*/
-			}
-			macro_content = ptr;
-			*(macro_content+strlen(macro_content)+1) = EOS; /*Ensure the new memory is null-terminated */
-			strcat(macro_content, line);
-		}
+			if (has_errors)
+				return ERROR;
+			
+			create_node(macro_name, content_start, content_end - content_start, ctx);
+			return SUCCESS;
+		}	
 		
-		free(first_field);
-	}
-	
-	free(macro_content);
-	free(ptr);
-	
-	return SUCCESS; /* Indicate success */
-}
-
-
-
-void create_node(char *macro_name, char *macro_content, node **head)
-{
-	/* Allocate memory for the MacroNode structure */
-	MacroNode *data = (MacroNode *)malloc(sizeof(MacroNode));
-	if (!data) 
-	{
-		printf("Allocation failure\n");
-		exit(1);
+		content_end = text + len;
 	}
 	
-	/*Allocate memory and copy the macro name */
-	data->name = (char *)malloc(strlen(macro_name+1));
-	if (!data->name)
-	{
-        	printf("Allocation failure\n");
-        	free(data);
-		exit(1);
-	}
-	strcpy(data->name, macro_name);
-	
-	/*  Allocate memory and copy the macro content*/
-	data->content = (char *)malloc(strlen(macro_content)+1);
-	if (!data->content)
-	{
-        	printf("Allocation failure\n");
-        	free(data->name);
-        	free(data);
-		exit(1);
-	}
-	strcpy(data->content, macro_content);
-	
-	add_node_end(head,(void *)data, delete_macro_node);
-	
-	/*free(data);*/
+	/* The source ended before the end line, the lines after the definition line are not assembled */
+	report(&ctx->diagnostics, "Error in line number %d: Macro '%.*s' is missing its endmacr line\n", definition_line, macro_name->length, macro_name->start);
+	return ERROR;
 }
 
 
 
-char * find_macro(char *first_field, node **head)
+void create_node(const Token *macro_name, const char *macro_content, int len, AssemblyContext *ctx)
 {
-	node * temp = *head;
-	MacroNode *data_m;
-
-	/* Traverse the linked list to find the macro */
-	while (temp != NULL)
-	{
-		data_m = (MacroNode *)temp->data;
-		if (strcmp(data_m->name, first_field) == 0)
-		{
-			return data_m->content;
-		}
-		temp = (node *)temp->next;
-	}
-	
-	/* Return NULL if the macro is not found */	
-	return NULL;
+	add_macro(&ctx->macros, macro_name->start, macro_name->length, macro_content, len);
 }
 
 
 
-void delete_macro_node(void *m)
+int create_am_file(char *name_file, AssemblyContext *ctx)
 {
-	MacroNode *data_macro_node = (MacroNode *)m;
-	free(data_macro_node -> name);
-	free(data_macro_node -> content);
-	free(data_macro_node);
+	/* Write the expanded source to the file with suffix m in one block */
+	return write_output_file(name_file, ".am", ctx->expanded.text, ctx->expanded.length, &ctx->diagnostics);
 }
-
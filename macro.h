@@ -1,31 +1,47 @@
 #ifndef MACRO_H
 #define MACRO_H
 
-#include "linked_list.h"
+#include "context.h"
+#include "macro_table.h"
+#include "lexer.h"
 
 
-typedef struct {
-	char *name;
-	char *content;
-} MacroNode;
+#define EXPANDED_CHUNK_SIZE 65536 /* With bounded memory, the first pass is handed the expanded source once it is this long */
+
+
+
+/**
+ * Maps a source file (with suffix s) into the source of the context, or reads the standard input if the name is STREAM_NAME ("-").
+ * If the file cannot be opened, an error message is reported to the diagnostics of the context.
+ *
+ * @param name_file The name of the file, without the .as suffix.
+ * @param ctx The assembly context of the file, its source must be closed.
+ * @return SUCCESS if the file was opened, ERROR otherwise.
+ */
+int open_source_file(char *name_file, AssemblyContext *ctx);
 
 
 
 /**
  * Analyzes a file, handling macros and replacing them with their content.
  *
- * This function reads a file line by line, processes macros defined in the file, and writes the output
- * to a new file. If a macro definition is found, it is processed and its content is stored in a linked list.
+ * This function goes over the source of the context (opened by open_source_file) line by line, processes macros defined in the file, and appends the output
+ * to the expanded source of the context, which the first pass reads in place of a file with suffix m.
+ * If a macro definition is found, it is processed and its content is stored in the macro table of the context.
  * Any occurrence of the macro in the subsequent lines is replaced with its content. If errors are found in
- * the macro definitions, appropriate error messages are printed and the function returns an error code.
+ * the macro definitions, or if a line is longer than MAX_LINE_CHARS characters, appropriate error messages
+ * are reported and the function returns an error code.
+ *
+ * With bounded memory, the expanded source is handed to the first pass (and emptied) whenever it grows past
+ * EXPANDED_CHUNK_SIZE, and the errors of the first pass are kept in the context (first_pass_errors).
+ * The part that is left at the end is for the first pass to finish.
  *
- * @param name_file The name of the file to be analyzed.
- * @param head_macro_list A pointer to a pointer to the head of the linked list that stores macros.
- *                        This list will be updated with the macros found in the file.
+ * @param ctx The assembly context of the file. Its macro table will be updated with the macros found in the file,
+ *            and its expanded source will hold the file after the macros are spread.
  * @return Returns SUCCESS if the file was processed correctly and ERROR if there was an error
- *         during processing (e.g., invalid macro definition or file operation failure).
+ *         during processing (e.g., invalid macro definition or a line that is too long).
  */
-int macro_analyze(char * name_file, node **head_macro_list);
+int macro_analyze(AssemblyContext *ctx);
 
 
 
@@ -33,58 +49,45 @@ int macro_analyze(char * name_file, node **head_macro_list);
 /**
  * Handles the processing of a macro within a file.
  *
- * This function reads lines from the file pointed to by `fp`, starting from the current
- * position, and processes the content of a macro until an "endmacr" directive is encountered.
- * It then creates a node with the macro's name and content and adds it to the linked list.
+ * This function reads lines from the source of the context, starting from the line after the
+ * definition line, and processes the content of a macro until an "endmacr" directive is encountered.
+ * It then creates a node with the macro's name and content and adds it to the macro table of the context.
+ * The content is not copied: it is the part of the source between the definition line and the end line.
+ * A macro whose end line is missing (the source ends first) is reported as an error.
  *
- * @param fp Pointer to the file pointer.
- * @param macro_name Name of the macro being processed.
- * @param head Pointer to the head of the linked list.
+ * @param macro_name Name of the macro being processed, as it appears in the definition line.
+ * @param ctx The assembly context of the file.
  * @return Returns SUCCESS if the macro was successfully processed, otherwise returns ERROR.
  */
-int handle_macro(FILE ** fp, char *macro_name, node **head);
+int handle_macro(const Token *macro_name, AssemblyContext *ctx);
 
 
 
 /**
- * create_node - Creates a new node with macro name and content, and adds it to the linked list.
+ * create_node - Creates a new node with macro name and content, and adds it to the macro table.
  * 
- * This function allocates memory for a new data_macro structure, assigns the macro name and content
- * to it, creates a new node with this data, and adds the node to the end of the linked list.
+ * This function allocates a new MacroNode structure from the arena of the context, copies the macro
+ * name into it, and adds it to the macro table of the context. The content is kept in place, it is not copied.
  * 
- * @param macro_name: The name of the macro.
- * @param macro_content: The content of the macro.
- * @param head: Pointer to the pointer of the head of the linked list.
+ * @param macro_name: The name of the macro, as it appears in the definition line.
+ * @param macro_content: The content of the macro, in the source of the context.
+ * @param len: The length of the content.
+ * @param ctx: The assembly context of the file.
  */
-void create_node(char *macro_name, char *macro_content, node **head);
+void create_node(const Token *macro_name, const char *macro_content, int len, AssemblyContext *ctx);
 
 
 
 /**
- * find_macro - Searches for a macro name in a linked list and returns its content.
- * 
- * This function traverses a linked list of nodes, each containing a data_macro structure,
- * and looks for a macro with a specified name. If found, it returns the content of the macro.
- * If the macro is not found, it returns NULL.
- * 
- * @param first_field: The name of the macro to be searched.
- * @param head: A pointer to the head of the linked list.
- * 
- * @return The content of the found macro, or NULL if the macro is not found.
+ * Writes the expanded source of the context (the source after the macros are spread) to a file with suffix m.
+ * The file is not needed by the assembler itself, it is created only when it is asked for.
+ *
+ * @param name_file The name of the source file.
+ * @param ctx The assembly context of the file.
+ * @return SUCCESS if the file was written, ERROR otherwise (the error is reported to the diagnostics of the context).
  */
-char * find_macro(char * first_field, node **head);
-
-
+int create_am_file(char *name_file, AssemblyContext *ctx);
 
-/**
- * Deletes memory allocated for a MacroNode structure.
- * 
- * This function frees the memory allocated for the content of the MacroNode
- * structure and then frees the MacroNode structure itself.
- * 
- * @param m A pointer to the MacroNode structure to be deleted.
- */
-void delete_macro_node(void *m);
 
 
 #endif 
@@ -0,0 +1,104 @@
+#include "macro_table.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+/* Returns the slot of the name, that is the slot that holds it or the empty slot where it should be inserted */
+static int find_slot(MacroTable *table, const char *name, int len, unsigned long hash)
+{
+	int mask = table->num_slots - 1;
+	int slot = (int)(hash & mask);
+	MacroNode *macro;
+
+	/* Linear probing until the name or an empty slot is found */
+	while ((macro = table->slots[slot]) != NULL && (macro->hash != hash || strncmp(macro->name, name, len) != 0 || macro->name[len] != EOS))
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+
+
+/* Doubles the number of hash slots and re-inserts all the macros */
+static void grow_slots(MacroTable *table)
+{
+	MacroNode **old_slots = table->slots;
+	int i, old_num_slots = table->num_slots;
+
+	table->num_slots = old_num_slots ? 2 * old_num_slots : MACRO_TABLE_INIT_SLOTS;
+	table->slots = (MacroNode **)memory_calloc(table->num_slots, sizeof(MacroNode *), MEMORY_MACROS);
+
+	for (i = 0; i < old_num_slots; i++)
+	{
+		if (old_slots[i] != NULL)
+			table->slots[find_slot(table, old_slots[i]->name, (int)strlen(old_slots[i]->name), old_slots[i]->hash)] = old_slots[i];
+	}
+
+	memory_free(old_slots);
+}
+
+
+
+void macro_table_init(MacroTable *table, Arena *arena)
+{
+	table->slots = NULL;
+	table->num_slots = 0;
+	table->count = 0;
+	table->arena = arena;
+}
+
+
+
+void macro_table_free(MacroTable *table)
+{
+	memory_free(table->slots);
+
+	macro_table_init(table, table->arena);
+}
+
+
+
+void add_macro(MacroTable *table, const char *name, int name_len, const char *content, int len)
+{
+	unsigned long hash = hash_span(name, name_len);
+	MacroNode *macro;
+	int slot;
+
+	/* Keep the load factor of the table at most 1/2 */
+	if (2 * (table->count + 1) > table->num_slots)
+		grow_slots(table);
+
+	slot = find_slot(table, name, name_len, hash);
+	if (table->slots[slot] != NULL)
+		return;
+
+	/* Allocate the MacroNode structure and its name from the arena, the content is kept in place */
+	macro = (MacroNode *)arena_alloc(table->arena, sizeof(MacroNode));
+	macro->name = arena_strndup(table->arena, name, name_len);
+	macro->content = content;
+	macro->length = len;
+	macro->hash = hash;
+
+	table->slots[slot] = macro;
+	table->count++;
+}
+
+
+
+MacroNode *find_macro(const char *name, int len, MacroTable *table)
+{
+	int slot;
+
+	if (table->count == 0)
+		return NULL;
+
+	slot = find_slot(table, name, len, hash_span(name, len));
+	if (table->slots[slot] == NULL)
+		return NULL;
+
+	return table->slots[slot];
+}
@@ -0,0 +1,77 @@
+#ifndef MACRO_TABLE_H
+#define MACRO_TABLE_H
+
+#include "arena.h"
+
+#define MACRO_TABLE_INIT_SLOTS 32 /* Initial number of hash slots, must be a power of 2 */
+
+
+typedef struct {
+	char *name;
+	const char *content; /* The lines of the macro, in the source of the file (not null-terminated) */
+	int length; /* The length of the content */
+	unsigned long hash; /* The hash of the name, compared before the names themselves */
+} MacroNode;
+
+
+/*
+ * The macro table is an open addressing hash table (linear probing) of the macros, keyed on the macro name.
+ * The macros and their names are allocated from the arena, the table only holds pointers to them.
+ */
+typedef struct {
+	MacroNode **slots;
+	int num_slots; /* Always a power of 2 */
+	int count;
+	Arena *arena;
+} MacroTable;
+
+
+
+/**
+ * Initializes an empty macro table.
+ *
+ * @param table The macro table to initialize.
+ * @param arena The arena that the macros are allocated from.
+ */
+void macro_table_init(MacroTable *table, Arena *arena);
+
+
+
+/**
+ * Frees the memory held by the macro table (the macros themselves are released with the arena).
+ * The table is left empty and can be used again.
+ *
+ * @param table The macro table to free.
+ */
+void macro_table_free(MacroTable *table);
+
+
+
+/**
+ * Adds a macro to the table. If a macro with the same name already exists, the table is not changed
+ * and the first definition is kept.
+ *
+ * @param table The macro table.
+ * @param name The name of the macro, it is copied into the arena.
+ * @param name_len The length of the name.
+ * @param content The content of the macro. It is not copied, and must stay valid as long as the table is used.
+ * @param len The length of the content.
+ */
+void add_macro(MacroTable *table, const char *name, int name_len, const char *content, int len);
+
+
+
+/**
+ * find_macro - Searches for a macro name in the macro table.
+ * 
+ * @param name: The name of the macro to be searched, it does not have to be null-terminated.
+ * @param len: The length of the name.
+ * @param table: The table that stores macros.
+ * 
+ * @return The found macro (with its content and length), or NULL if the macro is not found.
+ */
+MacroNode *find_macro(const char *name, int len, MacroTable *table);
+
+
+
+#endif
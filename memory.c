@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200112L /* For the thread-specific data */
+
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+
+/* Every block starts with a header that holds its size and subsystem, so that a free can be counted.
+   The union makes the memory after the header aligned for any type */
+typedef union {
+	struct {
+		size_t size;
+		int subsystem;
+	} info;
+	long l;
+	double d;
+	void *p;
+} MemoryHeader;
+
+
+const char *memory_subsystem_names[NUM_MEMORY_SUBSYSTEMS] = {
+	"arena", "source", "text", "symbols", "macros", "code", "lists", "diagnostics", "file_names", "driver"
+};
+
+
+static pthread_key_t account_key;
+static pthread_once_t account_key_once = PTHREAD_ONCE_INIT;
+
+
+
+static void create_account_key(void)
+{
+	pthread_key_create(&account_key, NULL);
+}
+
+
+
+static void allocation_failure(void)
+{
+	printf("Allocation failure\n");
+	exit(1);
+}
+
+
+
+/* Adds a change in the size of a block (negative when it is freed or shrinks) to the account of the calling thread.
+   An allocation is counted for its call site as well, (file is NULL for a free) */
+static void count_change(MemoryHeader *header, long change, const char *file, int line)
+{
+	MemoryAccount *account = memory_current_account();
+	MemoryCounters *counters[2];
+	int i, allocation = file != NULL;
+
+	if (account == NULL)
+		return;
+
+	if (allocation)
+		memory_count_call_site(account->call_sites, &account->num_call_sites, file, line, 1);
+
+	counters[0] = &account->subsystems[header->info.subsystem];
+	counters[1] = &account->total;
+
+	for (i = 0; i < 2; i++)
+	{
+		counters[i]->allocations += allocation;
+		counters[i]->live_bytes += change;
+		if (counters[i]->live_bytes > counters[i]->peak_bytes)
+			counters[i]->peak_bytes = counters[i]->live_bytes;
+	}
+}
+
+
+
+void *memory_alloc_at(size_t size, int subsystem, const char *file, int line)
+{
+	MemoryHeader *header = (MemoryHeader *)malloc(sizeof(MemoryHeader) + size);
+
+	if (!header)
+		allocation_failure();
+
+	header->info.size = size;
+	header->info.subsystem = subsystem;
+	count_change(header, (long)size, file, line);
+
+	return header + 1;
+}
+
+
+
+void *memory_calloc_at(size_t count, size_t size, int subsystem, const char *file, int line)
+{
+	void *ptr = memory_alloc_at(count * size, subsystem, file, line);
+
+	memset(ptr, 0, count * size);
+
+	return ptr;
+}
+
+
+
+void *memory_realloc_at(void *ptr, size_t size, int subsystem, const char *file, int line)
+{
+	MemoryHeader *header;
+	size_t old_size;
+
+	if (ptr == NULL)
+		return memory_alloc_at(size, subsystem, file, line);
+
+	header = (MemoryHeader *)ptr - 1;
+	old_size = header->info.size;
+
+	header = (MemoryHeader *)realloc(header, sizeof(MemoryHeader) + size);
+	if (!header)
+		allocation_failure();
+
+	header->info.size = size;
+	count_change(header, (long)size - (long)old_size, file, line);
+
+	return header + 1;
+}
+
+
+
+void memory_free(void *ptr)
+{
+	MemoryHeader *header;
+
+	if (ptr == NULL)
+		return;
+
+	header = (MemoryHeader *)ptr - 1;
+	count_change(header, -(long)header->info.size, NULL, 0);
+	free(header);
+}
+
+
+
+void memory_disown(void *ptr)
+{
+	MemoryHeader *header;
+
+	if (ptr == NULL)
+		return;
+
+	header = (MemoryHeader *)ptr - 1;
+	count_change(header, -(long)header->info.size, NULL, 0);
+}
+
+
+
+void memory_count_call_site(MemoryCallSite *sites, int *num_sites, const char *file, int line, long allocations)
+{
+	int i;
+
+	for (i = 0; i < *num_sites; i++)
+		if (sites[i].line == line && sites[i].file != NULL && file != NULL && strcmp(sites[i].file, file) == 0)
+			break;
+
+	/* The last place of the list is kept for the call sites that do not fit in it */
+	if (i == *num_sites)
+	{
+		if (i == MEMORY_MAX_CALL_SITES - 1 || file == NULL)
+		{
+			file = NULL;
+			line = 0;
+			for (i = 0; i < *num_sites && sites[i].file != NULL; i++)
+				;
+		}
+
+		if (i == *num_sites)
+		{
+			sites[i].file = file;
+			sites[i].line = line;
+			sites[i].allocations = 0;
+			(*num_sites)++;
+		}
+	}
+
+	sites[i].allocations += allocations;
+}
+
+
+
+void memory_account_init(MemoryAccount *account)
+{
+	memset(account, 0, sizeof(MemoryAccount));
+}
+
+
+
+void memory_account_reset(MemoryAccount *account)
+{
+	int i;
+
+	for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+	{
+		account->subsystems[i].allocations = 0;
+		account->subsystems[i].peak_bytes = account->subsystems[i].live_bytes;
+	}
+
+	account->total.allocations = 0;
+	account->total.peak_bytes = account->total.live_bytes;
+	account->num_call_sites = 0;
+}
+
+
+
+void memory_use_account(MemoryAccount *account)
+{
+	pthread_once(&account_key_once, create_account_key);
+	pthread_setspecific(account_key, account);
+}
+
+
+
+MemoryAccount *memory_current_account(void)
+{
+	pthread_once(&account_key_once, create_account_key);
+	return (MemoryAccount *)pthread_getspecific(account_key);
+}
@@ -0,0 +1,176 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+
+/* The subsystems that the allocations are attributed to */
+#define MEMORY_ARENA 0 /* The blocks of the arenas (macros, symbol names, extern references) */
+#define MEMORY_SOURCE 1 /* The source files that are read instead of mapped, and their line indexes */
+#define MEMORY_TEXT 2 /* The text buffers (the expanded source and the output files) */
+#define MEMORY_SYMBOLS 3 /* The arrays and the hash index of the symbol table */
+#define MEMORY_MACROS 4 /* The hash index of the macro table */
+#define MEMORY_CODE 5 /* The code and data images, and the fixups */
+#define MEMORY_LISTS 6 /* The node blocks of the linked lists */
+#define MEMORY_DIAGNOSTICS 7 /* The message buffers */
+#define MEMORY_FILE_NAMES 8 /* The names of the input and output files */
+#define MEMORY_DRIVER 9 /* The worker pool */
+#define NUM_MEMORY_SUBSYSTEMS 10
+
+#define MEMORY_MAX_CALL_SITES 64 /* The call sites that are counted apart, the allocations of any others are counted together */
+
+
+/* The allocations of a subsystem (or of all of them) */
+typedef struct {
+	long allocations; /* The calls that allocated or resized a block */
+	long live_bytes; /* The bytes of the blocks that are allocated now */
+	long peak_bytes; /* The largest value of live_bytes since the account was reset */
+} MemoryCounters;
+
+
+/* The allocations of one call site of memory_alloc, memory_calloc or memory_realloc */
+typedef struct {
+	const char *file; /* The source file of the call (__FILE__), or NULL for the call sites past MEMORY_MAX_CALL_SITES */
+	int line;
+	long allocations;
+} MemoryCallSite;
+
+
+/*
+ * The allocations of a thread. Each thread may have an account of its own (memory_use_account), and while it does,
+ * every allocation and free of the thread is counted in it. A thread without an account allocates without counting.
+ * A block that is freed by another thread than the one that allocated it should be handed over with memory_disown.
+ */
+typedef struct {
+	MemoryCounters subsystems[NUM_MEMORY_SUBSYSTEMS];
+	MemoryCounters total;
+	MemoryCallSite call_sites[MEMORY_MAX_CALL_SITES]; /* The call sites that allocated, in the order of their first allocation */
+	int num_call_sites;
+} MemoryAccount;
+
+
+extern const char *memory_subsystem_names[NUM_MEMORY_SUBSYSTEMS];
+
+
+
+/* The allocation functions are called through these macros, which pass the call site that the allocation is counted for */
+#define memory_alloc(size, subsystem) memory_alloc_at(size, subsystem, __FILE__, __LINE__)
+#define memory_calloc(count, size, subsystem) memory_calloc_at(count, size, subsystem, __FILE__, __LINE__)
+#define memory_realloc(ptr, size, subsystem) memory_realloc_at(ptr, size, subsystem, __FILE__, __LINE__)
+
+
+
+/**
+ * Allocates memory, aligned for any type (memory_alloc).
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param size The number of bytes to allocate.
+ * @param subsystem The subsystem that the memory is attributed to (MEMORY_...).
+ * @param file The source file of the call.
+ * @param line The line of the call.
+ * @return A pointer to the allocated memory.
+ */
+void *memory_alloc_at(size_t size, int subsystem, const char *file, int line);
+
+
+
+/**
+ * Allocates memory for an array, and sets all of it to zero (memory_calloc).
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param count The number of elements.
+ * @param size The size of an element.
+ * @param subsystem The subsystem that the memory is attributed to (MEMORY_...).
+ * @param file The source file of the call.
+ * @param line The line of the call.
+ * @return A pointer to the allocated memory.
+ */
+void *memory_calloc_at(size_t count, size_t size, int subsystem, const char *file, int line);
+
+
+
+/**
+ * Changes the size of a block (or allocates a new one, if ptr is NULL), keeping its content (memory_realloc).
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param ptr The block, allocated by this module, or NULL.
+ * @param size The new size of the block, in bytes.
+ * @param subsystem The subsystem that a new block is attributed to (a block keeps its subsystem).
+ * @param file The source file of the call.
+ * @param line The line of the call.
+ * @return A pointer to the block, which may have moved.
+ */
+void *memory_realloc_at(void *ptr, size_t size, int subsystem, const char *file, int line);
+
+
+
+/**
+ * Frees a block that was allocated by this module. Nothing is done if ptr is NULL.
+ *
+ * @param ptr The block to free, or NULL.
+ */
+void memory_free(void *ptr);
+
+
+
+/**
+ * Removes a block from the account of the calling thread, before it is handed over to another thread that frees it.
+ *
+ * @param ptr The block, or NULL.
+ */
+void memory_disown(void *ptr);
+
+
+
+/**
+ * Adds allocations to the count of a call site in a list of call sites. A call site that is not in the list yet
+ * is added at its end, or counted with the other call sites (file NULL) once the list has MEMORY_MAX_CALL_SITES - 1 of them.
+ *
+ * @param sites The list of call sites, MEMORY_MAX_CALL_SITES long.
+ * @param num_sites The number of call sites in the list, it is updated.
+ * @param file The source file of the call site.
+ * @param line The line of the call site.
+ * @param allocations The number of allocations to add.
+ */
+void memory_count_call_site(MemoryCallSite *sites, int *num_sites, const char *file, int line, long allocations);
+
+
+
+/**
+ * Initializes an account with no allocations.
+ *
+ * @param account The account to initialize.
+ */
+void memory_account_init(MemoryAccount *account);
+
+
+
+/**
+ * Starts a new measurement in an account: the allocation counts are set to zero (and the call sites are cleared),
+ * and the peaks are set to the live bytes.
+ *
+ * @param account The account to reset.
+ */
+void memory_account_reset(MemoryAccount *account);
+
+
+
+/**
+ * Sets the account that the allocations of the calling thread are counted in.
+ *
+ * @param account The account, or NULL to stop counting.
+ */
+void memory_use_account(MemoryAccount *account);
+
+
+
+/**
+ * Returns the account of the calling thread.
+ *
+ * @return The account, or NULL if the allocations of the thread are not counted.
+ */
+MemoryAccount *memory_current_account(void);
+
+
+
+#endif
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "utils_and_checks.h"
+#include "object_file.h"
+#include "output.h"
+#include "memory.h"
+
+
+/*
+ * Converts an object file between the text format and the binary format:
+ *
+ *     obconv file.ob     writes file.bin, with the entry labels of file.ent and the extern references of file.ext (if they exist)
+ *     obconv file.bin    writes file.ob, and file.ent and file.ext if the file has entry labels or extern references
+ *
+ * The files that are written are the same as the ones that the assembler writes for the source in the other format
+ * (--object=text, --object=binary). Error messages are printed to the standard output, and the exit status is 1.
+ */
+
+
+
+/* Converts an object file to the other format, name_file is the name of the file without its suffix */
+static int convert(const char *file_name, const char *name_file, int to_binary, TextBuffer *out, Diagnostics *diagnostics)
+{
+	ObjectImage image;
+	int result;
+
+	object_image_init(&image);
+
+	result = object_load(&image, file_name, diagnostics);
+
+	if (result == SUCCESS && to_binary)
+	{
+		object_format_binary(&image, out);
+		result = write_output_file(name_file, ".bin", out->text, out->length, diagnostics);
+	}
+	else if (result == SUCCESS)
+	{
+		object_format_text(&image, out);
+		result = write_output_file(name_file, ".ob", out->text, out->length, diagnostics);
+
+		/* As with the assembler, the entries and externals files are created only if there are such labels */
+		if (result == SUCCESS && image.num_symbols > 0)
+		{
+			object_format_records(image.symbols, image.num_symbols, out);
+			result = write_output_file(name_file, ".ent", out->text, out->length, diagnostics);
+		}
+
+		if (result == SUCCESS && image.num_relocations > 0)
+		{
+			object_format_records(image.relocations, image.num_relocations, out);
+			result = write_output_file(name_file, ".ext", out->text, out->length, diagnostics);
+		}
+	}
+
+	object_image_free(&image);
+
+	return result;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	TextBuffer out;
+	Diagnostics diagnostics;
+	char *name_file;
+	size_t len;
+	int result = ERROR, to_binary;
+
+	output_init();
+
+	if (argc != 2)
+	{
+		printf("Usage: obconv file.ob | file.bin\n");
+		return 1;
+	}
+
+	text_buffer_init(&out);
+	diagnostics_init(&diagnostics);
+
+	/* The name of the file without its extension is the base name of all the files of the object */
+	len = strlen(argv[1]);
+	to_binary = len > 3 && strcmp(argv[1] + len - 3, ".ob") == 0;
+
+	if (to_binary || (len > 4 && strcmp(argv[1] + len - 4, ".bin") == 0))
+	{
+		name_file = generate_full_name(argv[1], "");
+		name_file[len - (to_binary ? 3 : 4)] = EOS;
+		result = convert(argv[1], name_file, to_binary, &out, &diagnostics);
+		memory_free(name_file);
+	}
+	else
+		printf("Error! The file %s is not an object file, (its extension must be .ob or .bin)\n", argv[1]);
+
+	diagnostics_flush(&diagnostics, stdout);
+	diagnostics_free(&diagnostics);
+	text_buffer_free(&out);
+
+	return result == ERROR;
+}
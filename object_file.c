@@ -0,0 +1,492 @@
+#include "object_file.h"
+#include "output.h"
+#include "first_pass.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include "source_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+#define MIN_TEXT_WORD_SIZE 11 /* The shortest line of a word in a text object file, "AAAA OOOOO\n" */
+#define MAX_WORD 077777 /* The largest 15-bit word */
+#define INITIAL_RECORDS 16
+#define MAX_FILE_ADDRESS 0x7FFFFFFFL /* The address after the last word of an image must fit in an int */
+
+
+
+/* Writes numbers as little-endian bytes */
+static void put_u16(char *dest, unsigned int value)
+{
+	dest[0] = (char)(value & 0xFF);
+	dest[1] = (char)((value >> 8) & 0xFF);
+}
+
+
+
+static void put_u32(char *dest, unsigned long value)
+{
+	put_u16(dest, (unsigned int)(value & 0xFFFF));
+	put_u16(dest + 2, (unsigned int)((value >> 16) & 0xFFFF));
+}
+
+
+
+/* Reads little-endian numbers */
+static unsigned int get_u16(const char *src)
+{
+	return (unsigned int)(unsigned char)src[0] | ((unsigned int)(unsigned char)src[1] << 8);
+}
+
+
+
+static unsigned long get_u32(const char *src)
+{
+	return (unsigned long)get_u16(src) | ((unsigned long)get_u16(src + 2) << 16);
+}
+
+
+
+/* Allocates the words of an image that is read from a file, the code and the data are one allocation */
+static void allocate_words(ObjectImage *image, int code_count, int data_count)
+{
+	image->code = (uint16_t *)memory_alloc((code_count + data_count + 1) * sizeof(uint16_t), MEMORY_CODE);
+	image->data = image->code + code_count;
+	image->code_count = code_count;
+	image->data_count = data_count;
+	image->owns_words = 1;
+}
+
+
+
+const char *object_extension(int format)
+{
+	return format == OBJECT_BINARY ? ".bin" : ".ob";
+}
+
+
+
+void object_image_init(ObjectImage *image)
+{
+	image->code = NULL;
+	image->code_count = 0;
+	image->data = NULL;
+	image->data_count = 0;
+	image->base_address = MEMORY_START_ADDRESS;
+	image->owns_words = 0;
+	image->symbols = NULL;
+	image->num_symbols = 0;
+	image->symbols_capacity = 0;
+	image->relocations = NULL;
+	image->num_relocations = 0;
+	image->relocations_capacity = 0;
+}
+
+
+
+void object_add_record(ObjectImage *image, int is_relocation, const char *name, int address)
+{
+	ObjectRecord **records = is_relocation ? &image->relocations : &image->symbols;
+	int *count = is_relocation ? &image->num_relocations : &image->num_symbols;
+	int *capacity = is_relocation ? &image->relocations_capacity : &image->symbols_capacity;
+	ObjectRecord *record;
+
+	if (*count == *capacity)
+	{
+		*capacity = *capacity ? 2 * *capacity : INITIAL_RECORDS;
+		*records = (ObjectRecord *)memory_realloc(*records, *capacity * sizeof(ObjectRecord), MEMORY_CODE);
+	}
+
+	record = &(*records)[(*count)++];
+	strncpy(record->name, name, OBJECT_NAME_SIZE - 1);
+	record->name[OBJECT_NAME_SIZE - 1] = EOS;
+	record->address = address;
+}
+
+
+
+void object_image_free(ObjectImage *image)
+{
+	if (image->owns_words)
+		memory_free(image->code);
+	memory_free(image->symbols);
+	memory_free(image->relocations);
+	object_image_init(image);
+}
+
+
+
+void object_format_text_header(int code_count, int data_count, TextBuffer *out)
+{
+	text_buffer_append(out, " ", 1);
+	output_number(out, code_count, 1);
+	text_buffer_append(out, " ", 1);
+	output_number(out, data_count, 1);
+	text_buffer_append(out, "\n", 1);
+}
+
+
+
+void object_format_text(const ObjectImage *image, TextBuffer *out)
+{
+	int i, data_base = image->base_address + image->code_count;
+
+	/* Every word takes one line of a fixed length */
+	out->length = 0;
+	text_buffer_reserve(out, (image->code_count + image->data_count + 1) * (ADDRESS_WIDTH + OCTAL_WORD_WIDTH + 2));
+
+	object_format_text_header(image->code_count, image->data_count, out);
+
+	for (i = 0; i < image->code_count; i++)
+		output_word(out, image->base_address + i, image->code[i]);
+
+	/* The data section starts right after the instructions */
+	for (i = 0; i < image->data_count; i++)
+		output_word(out, data_base + i, image->data[i]);
+}
+
+
+
+void object_format_records(const ObjectRecord *records, int count, TextBuffer *out)
+{
+	int i;
+
+	out->length = 0;
+
+	for (i = 0; i < count; i++)
+		output_label(out, records[i].name, records[i].address);
+}
+
+
+
+/* Writes the records of a section at the destination */
+static void format_binary_records(char *dest, const ObjectRecord *records, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++, dest += OBJECT_RECORD_SIZE)
+	{
+		put_u32(dest, (unsigned long)records[i].address);
+		strncpy(dest + 4, records[i].name, OBJECT_NAME_SIZE);
+	}
+}
+
+
+
+void object_format_binary(const ObjectImage *image, TextBuffer *out)
+{
+	size_t words_offset = OBJECT_HEADER_SIZE, symbols_offset, relocations_offset, size;
+	char *dest;
+	int i;
+
+	/* The sections of records start at multiples of 4 */
+	symbols_offset = (words_offset + 2 * (image->code_count + image->data_count) + 3) & ~(size_t)3;
+	relocations_offset = symbols_offset + (size_t)image->num_symbols * OBJECT_RECORD_SIZE;
+	size = relocations_offset + (size_t)image->num_relocations * OBJECT_RECORD_SIZE;
+
+	out->length = 0;
+	dest = text_buffer_extend(out, (int)size);
+	memset(dest, 0, size);
+
+	memcpy(dest, OBJECT_MAGIC, 4);
+	put_u16(dest + 4, OBJECT_VERSION);
+	put_u16(dest + 6, OBJECT_HEADER_SIZE);
+	put_u32(dest + 8, (unsigned long)image->code_count);
+	put_u32(dest + 12, (unsigned long)image->data_count);
+	put_u32(dest + 16, (unsigned long)image->base_address);
+	put_u32(dest + 20, (unsigned long)words_offset);
+	put_u32(dest + 24, (unsigned long)symbols_offset);
+	put_u32(dest + 28, (unsigned long)image->num_symbols);
+	put_u32(dest + 32, (unsigned long)relocations_offset);
+	put_u32(dest + 36, (unsigned long)image->num_relocations);
+
+	for (i = 0; i < image->code_count; i++)
+		put_u16(dest + words_offset + 2 * i, image->code[i]);
+	for (i = 0; i < image->data_count; i++)
+		put_u16(dest + words_offset + 2 * (image->code_count + i), image->data[i]);
+
+	format_binary_records(dest + symbols_offset, image->symbols, image->num_symbols);
+	format_binary_records(dest + relocations_offset, image->relocations, image->num_relocations);
+}
+
+
+
+/* Reads a number in a base (10 or 8) at *pos, and moves *pos after it. Returns -1 if there are no digits */
+static long read_number(const char *text, size_t size, size_t *pos, int base)
+{
+	long num = 0;
+	size_t start = *pos;
+
+	while (*pos < size && text[*pos] >= '0' && text[*pos] < '0' + base && num < 0x7FFFFFFFL / base)
+		num = num * base + (text[(*pos)++] - '0');
+
+	return *pos == start ? -1 : num;
+}
+
+
+
+/* Checks that the character at *pos is the expected one, and moves *pos after it */
+static int expect_char(const char *text, size_t size, size_t *pos, char expected)
+{
+	if (*pos >= size || text[*pos] != expected)
+		return ERROR;
+
+	(*pos)++;
+	return SUCCESS;
+}
+
+
+
+/* Checks the addresses of the records of an image: an entry label is in the image, or right after it
+   (a label at the end of the data), and an external word is an instruction word */
+static int check_record_addresses(const ObjectImage *image)
+{
+	int i, code_end = image->base_address + image->code_count, end = code_end + image->data_count;
+
+	for (i = 0; i < image->num_symbols; i++)
+		if (image->symbols[i].address < image->base_address || image->symbols[i].address > end)
+			return ERROR;
+
+	for (i = 0; i < image->num_relocations; i++)
+		if (image->relocations[i].address < image->base_address || image->relocations[i].address >= code_end)
+			return ERROR;
+
+	return SUCCESS;
+}
+
+
+
+/* Reads the lines of an entries or externals file ("<name> <address>\n") into a section of the image */
+static int read_text_records(ObjectImage *image, int is_relocation, const char *text, size_t size)
+{
+	char name[OBJECT_NAME_SIZE];
+	size_t pos = 0, start;
+	long address;
+
+	while (pos < size)
+	{
+		for (start = pos; pos < size && text[pos] != ' ' && text[pos] != '\n'; pos++)
+			;
+		if (pos == start || pos - start >= OBJECT_NAME_SIZE)
+			return ERROR;
+		memcpy(name, text + start, pos - start);
+		name[pos - start] = EOS;
+
+		if (expect_char(text, size, &pos, ' ') == ERROR || (address = read_number(text, size, &pos, 10)) < 0
+			|| expect_char(text, size, &pos, '\n') == ERROR)
+			return ERROR;
+
+		object_add_record(image, is_relocation, name, (int)address);
+	}
+
+	return SUCCESS;
+}
+
+
+
+int object_read_text(ObjectImage *image, const char *ob, size_t ob_size, const char *ent, size_t ent_size, const char *ext, size_t ext_size)
+{
+	size_t pos = 0;
+	long code_count, data_count, address, word;
+	int i;
+
+	/* The header, " <instruction words> <data words>\n" */
+	while (pos < ob_size && ob[pos] == ' ')
+		pos++;
+	code_count = read_number(ob, ob_size, &pos, 10);
+	if (expect_char(ob, ob_size, &pos, ' ') == ERROR)
+		return ERROR;
+	data_count = read_number(ob, ob_size, &pos, 10);
+	if (code_count < 0 || data_count < 0 || expect_char(ob, ob_size, &pos, '\n') == ERROR
+		|| (size_t)(code_count + data_count) > ob_size / MIN_TEXT_WORD_SIZE)
+		return ERROR;
+
+	allocate_words(image, (int)code_count, (int)data_count);
+
+	/* Every word has its address, the addresses follow each other from the first one */
+	for (i = 0; i < code_count + data_count; i++)
+	{
+		address = read_number(ob, ob_size, &pos, 10);
+		if (i == 0)
+			image->base_address = (int)address;
+
+		if (address != image->base_address + i || expect_char(ob, ob_size, &pos, ' ') == ERROR)
+			return ERROR;
+
+		word = read_number(ob, ob_size, &pos, 8);
+		if (word < 0 || word > MAX_WORD || expect_char(ob, ob_size, &pos, '\n') == ERROR)
+			return ERROR;
+
+		image->code[i] = (uint16_t)word;
+	}
+
+	if (pos != ob_size)
+		return ERROR;
+
+	if (ent != NULL && read_text_records(image, 0, ent, ent_size) == ERROR)
+		return ERROR;
+
+	if (ext != NULL && read_text_records(image, 1, ext, ext_size) == ERROR)
+		return ERROR;
+
+	return check_record_addresses(image);
+}
+
+
+
+/* Reads the records of a section of a binary object file, returns ERROR if the section is not inside the file */
+static int read_binary_records(ObjectImage *image, int is_relocation, const char *data, size_t size, unsigned long offset, unsigned long count)
+{
+	const char *record;
+	unsigned long i;
+
+	if (offset > size || count > (size - offset) / OBJECT_RECORD_SIZE)
+		return ERROR;
+
+	for (i = 0, record = data + offset; i < count; i++, record += OBJECT_RECORD_SIZE)
+	{
+		/* The name must end inside its field */
+		if (memchr(record + 4, EOS, OBJECT_NAME_SIZE) == NULL || get_u32(record) > MAX_FILE_ADDRESS)
+			return ERROR;
+
+		object_add_record(image, is_relocation, record + 4, (int)get_u32(record));
+	}
+
+	return SUCCESS;
+}
+
+
+
+int object_read_binary(ObjectImage *image, const char *data, size_t size)
+{
+	unsigned long code_count, data_count, words_offset, num_words, base_address, word, i;
+
+	if (size < OBJECT_HEADER_SIZE || memcmp(data, OBJECT_MAGIC, 4) != 0 || get_u16(data + 4) != OBJECT_VERSION
+		|| get_u16(data + 6) < OBJECT_HEADER_SIZE)
+		return ERROR;
+
+	code_count = get_u32(data + 8);
+	data_count = get_u32(data + 12);
+	base_address = get_u32(data + 16);
+	words_offset = get_u32(data + 20);
+
+	/* The words must be inside the file, and their addresses must fit in an int */
+	if (words_offset > size || code_count > (size - words_offset) / 2 || data_count > (size - words_offset) / 2 - code_count
+		|| base_address > MAX_FILE_ADDRESS - code_count - data_count)
+		return ERROR;
+
+	allocate_words(image, (int)code_count, (int)data_count);
+	image->base_address = (int)base_address;
+
+	/* Every word has 15 bits, as in the text format */
+	num_words = code_count + data_count;
+	for (i = 0; i < num_words; i++)
+	{
+		word = get_u16(data + words_offset + 2 * i);
+		if (word > MAX_WORD)
+			return ERROR;
+
+		image->code[i] = (uint16_t)word;
+	}
+
+	if (read_binary_records(image, 0, data, size, get_u32(data + 24), get_u32(data + 28)) == ERROR
+		|| read_binary_records(image, 1, data, size, get_u32(data + 32), get_u32(data + 36)) == ERROR)
+		return ERROR;
+
+	return check_record_addresses(image);
+}
+
+
+
+/* Opens a file of an object, returns ERROR if it cannot be opened (the error is reported only if the file is required) */
+static int open_object_part(SourceFile *file, const char *name_file, const char *extension, int required, Diagnostics *diagnostics)
+{
+	char *path = generate_full_name(name_file, extension);
+	int result = source_open(file, path);
+
+	if (result == ERROR && required)
+		report(diagnostics, "Error! The file %s cannot be opened for reading\n", path);
+
+	memory_free(path);
+	return result;
+}
+
+
+
+/* Loads name_file.ob, with its .ent and .ext files */
+static int load_text(ObjectImage *image, const char *name_file, Diagnostics *diagnostics)
+{
+	SourceFile ob, ent, ext;
+	int has_ent, has_ext, result;
+
+	source_init(&ob);
+	source_init(&ent);
+	source_init(&ext);
+
+	if (open_object_part(&ob, name_file, ".ob", 1, diagnostics) == ERROR)
+		return ERROR;
+
+	has_ent = open_object_part(&ent, name_file, ".ent", 0, diagnostics) == SUCCESS;
+	has_ext = open_object_part(&ext, name_file, ".ext", 0, diagnostics) == SUCCESS;
+
+	result = object_read_text(image, ob.data, ob.size, has_ent ? ent.data : NULL, ent.size, has_ext ? ext.data : NULL, ext.size);
+	if (result == ERROR)
+		report(diagnostics, "Error! The object file %s.ob, or one of its .ent and .ext files, is not valid\n", name_file);
+
+	source_free(&ob);
+	source_free(&ent);
+	source_free(&ext);
+
+	return result;
+}
+
+
+
+/* Loads name_file.bin */
+static int load_binary(ObjectImage *image, const char *name_file, Diagnostics *diagnostics)
+{
+	SourceFile bin;
+	int result;
+
+	source_init(&bin);
+
+	if (open_object_part(&bin, name_file, ".bin", 1, diagnostics) == ERROR)
+		return ERROR;
+
+	result = object_read_binary(image, bin.data, bin.size);
+	if (result == ERROR)
+		report(diagnostics, "Error! The file %s.bin is not a valid binary object file\n", name_file);
+
+	source_free(&bin);
+
+	return result;
+}
+
+
+
+int object_load(ObjectImage *image, const char *file_name, Diagnostics *diagnostics)
+{
+	size_t len = strlen(file_name);
+	char *name_file;
+	int result;
+
+	/* The files of the object are named by the name without its suffix */
+	name_file = (char *)memory_alloc(len + 1, MEMORY_FILE_NAMES);
+	strcpy(name_file, file_name);
+
+	if (len > 4 && strcmp(file_name + len - 4, ".bin") == 0)
+	{
+		name_file[len - 4] = EOS;
+		result = load_binary(image, name_file, diagnostics);
+	}
+	else
+	{
+		if (len > 3 && strcmp(file_name + len - 3, ".ob") == 0)
+			name_file[len - 3] = EOS;
+		result = load_text(image, name_file, diagnostics);
+	}
+
+	memory_free(name_file);
+	return result;
+}
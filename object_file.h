@@ -0,0 +1,200 @@
+#ifndef OBJECT_FILE_H
+#define OBJECT_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "text_buffer.h"
+#include "diagnostics.h"
+
+
+/* The formats of the object file (--object=text and --object=binary) */
+#define OBJECT_TEXT 0 /* The file with suffix ob, a line of an address in decimal and a word in octal for every word */
+#define OBJECT_BINARY 1 /* The file with suffix bin, described below */
+
+#define OBJECT_MAGIC "AOBJ"
+#define OBJECT_VERSION 1
+#define OBJECT_HEADER_SIZE 40
+#define OBJECT_NAME_SIZE 32 /* The name field of a record, a label of up to 31 characters padded with null characters */
+#define OBJECT_RECORD_SIZE (4 + OBJECT_NAME_SIZE)
+
+
+/*
+ * The binary object format. All the numbers are little-endian, and the file starts with a header of 40 bytes:
+ *
+ *     offset  size
+ *     0       4     the magic "AOBJ"
+ *     4       2     the version of the format (1)
+ *     6       2     the size of the header (40)
+ *     8       4     the number of instruction words (the length of the IC)
+ *     12      4     the number of data words (the length of the DC)
+ *     16      4     the base address, of the first instruction word
+ *     20      4     the offset of the words
+ *     24      4     the offset of the symbol section
+ *     28      4     the number of symbols
+ *     32      4     the offset of the relocation section
+ *     36      4     the number of relocations
+ *
+ * The words are the instruction words followed by the data words, 2 bytes each, so the data section starts at
+ * the base address plus the number of instruction words. Every record of the symbol section is an entry label
+ * (as in the file with suffix ent), and every record of the relocation section is a word that refers to an external
+ * label (as in the file with suffix ext): the address in 4 bytes, and the name of the label in 32 bytes.
+ * The sections start at offsets that are multiples of 4, so that a loader can map the file and use it in place.
+ */
+
+
+/* A record of the symbol section or of the relocation section */
+typedef struct {
+	char name[OBJECT_NAME_SIZE]; /* Null-terminated */
+	int address;
+} ObjectRecord;
+
+
+/*
+ * An object file in memory, in either format. The words may belong to the image (when it was read from a file),
+ * or be borrowed from the images of an assembly context, (when it is only a view for writing them).
+ */
+typedef struct {
+	uint16_t *code;
+	int code_count;
+	uint16_t *data;
+	int data_count;
+	int base_address;
+	int owns_words; /* 1 if the words were allocated for the image, (code and data are one allocation) */
+	ObjectRecord *symbols; /* The entry labels */
+	int num_symbols;
+	int symbols_capacity;
+	ObjectRecord *relocations; /* The words that refer to external labels */
+	int num_relocations;
+	int relocations_capacity;
+} ObjectImage;
+
+
+
+/**
+ * Returns the extension of the object file in a format.
+ *
+ * @param format OBJECT_TEXT or OBJECT_BINARY.
+ * @return ".ob" or ".bin".
+ */
+const char *object_extension(int format);
+
+
+
+/**
+ * Initializes an empty image.
+ *
+ * @param image The image to initialize.
+ */
+void object_image_init(ObjectImage *image);
+
+
+
+/**
+ * Adds a record to the symbol section or to the relocation section of an image.
+ *
+ * @param image The image.
+ * @param is_relocation 1 to add to the relocation section, 0 to add to the symbol section.
+ * @param name The name of the label, of up to OBJECT_NAME_SIZE - 1 characters (a longer name is cut).
+ * @param address The address of the label, or of the word that refers to it.
+ */
+void object_add_record(ObjectImage *image, int is_relocation, const char *name, int address);
+
+
+
+/**
+ * Frees the records of an image, and its words if they belong to it.
+ *
+ * @param image The image to free.
+ */
+void object_image_free(ObjectImage *image);
+
+
+
+/**
+ * Appends the header line of a text object file to a buffer, the lengths of the instruction section and of the data section.
+ *
+ * @param code_count The number of instruction words.
+ * @param data_count The number of data words.
+ * @param out The buffer to append to.
+ */
+void object_format_text_header(int code_count, int data_count, TextBuffer *out);
+
+
+
+/**
+ * Formats the words of an image as a text object file (the file with suffix ob).
+ *
+ * @param image The image.
+ * @param out The buffer that the file is formatted in, its content is replaced.
+ */
+void object_format_text(const ObjectImage *image, TextBuffer *out);
+
+
+
+/**
+ * Formats records as the lines of an entries or externals file (a name and an address in every line).
+ *
+ * @param records The records.
+ * @param count The number of records.
+ * @param out The buffer that the file is formatted in, its content is replaced.
+ */
+void object_format_records(const ObjectRecord *records, int count, TextBuffer *out);
+
+
+
+/**
+ * Formats an image as a binary object file.
+ *
+ * @param image The image.
+ * @param out The buffer that the file is formatted in, its content is replaced.
+ */
+void object_format_binary(const ObjectImage *image, TextBuffer *out);
+
+
+
+/**
+ * Reads a text object file, and the entries and externals files that come with it, into an image.
+ * The address of an entry label must be in the image (or right after it), and the address of an external word
+ * must be an instruction word.
+ *
+ * @param image An empty image, it owns the words that are read.
+ * @param ob The content of the object file.
+ * @param ob_size The size of the object file.
+ * @param ent The content of the entries file, or NULL if there is none.
+ * @param ent_size The size of the entries file.
+ * @param ext The content of the externals file, or NULL if there is none.
+ * @param ext_size The size of the externals file.
+ * @return SUCCESS if the files are valid, ERROR otherwise.
+ */
+int object_read_text(ObjectImage *image, const char *ob, size_t ob_size, const char *ent, size_t ent_size, const char *ext, size_t ext_size);
+
+
+
+/**
+ * Reads a binary object file into an image. As in the text format, every word must have 15 bits, the address of
+ * an entry label must be in the image (or right after it), and the address of an external word must be an instruction word.
+ *
+ * @param image An empty image, it owns the words that are read.
+ * @param data The content of the file.
+ * @param size The size of the file.
+ * @return SUCCESS if the file is valid, ERROR otherwise.
+ */
+int object_read_binary(ObjectImage *image, const char *data, size_t size);
+
+
+
+/**
+ * Loads an object file into an image. A name that ends with .bin is read as a binary object file, any other name
+ * is read as a text object file (the suffix .ob is added if it is missing), together with the .ent and .ext files
+ * next to it, if they exist.
+ *
+ * @param image An empty image, it owns the words that are read.
+ * @param file_name The name of the object file.
+ * @param diagnostics The buffer that an error message is reported to.
+ * @return SUCCESS if the file was loaded, ERROR otherwise (the error is reported).
+ */
+int object_load(ObjectImage *image, const char *file_name, Diagnostics *diagnostics);
+
+
+
+#endif
@@ -0,0 +1,300 @@
+#define _POSIX_C_SOURCE 200809L /* For open, write, mkstemp, fchmod and umask */
+
+#include "output.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+
+#define MAX_DECIMAL_DIGITS 10 /* The number of digits of the largest int */
+#define COMPARE_BLOCK_SIZE 8192 /* The size of the blocks that an existing output file is read in, to compare it */
+#define TEMP_SUFFIX ".XXXXXX" /* The suffix of a temporary output file, replaced by mkstemp with a unique one */
+#define OUTPUT_FILE_MODE 0666 /* The permissions of an output file before the umask is applied, as open applies it (mkstemp creates the file for its owner only) */
+
+
+/* 
+ * The 3 octal digits of every 9-bit number, computed by the compiler.
+ * A 15-bit word is its high 6 bits (the last 2 digits of their entry) followed by its low 9 bits.
+ */
+#define OCTAL_ENTRY(n) {'0' + (((n) >> 6) & 7), '0' + (((n) >> 3) & 7), '0' + ((n) & 7)}
+#define OCTAL_8(n) OCTAL_ENTRY(n), OCTAL_ENTRY((n) + 1), OCTAL_ENTRY((n) + 2), OCTAL_ENTRY((n) + 3), \
+	OCTAL_ENTRY((n) + 4), OCTAL_ENTRY((n) + 5), OCTAL_ENTRY((n) + 6), OCTAL_ENTRY((n) + 7)
+#define OCTAL_64(n) OCTAL_8(n), OCTAL_8((n) + 8), OCTAL_8((n) + 16), OCTAL_8((n) + 24), \
+	OCTAL_8((n) + 32), OCTAL_8((n) + 40), OCTAL_8((n) + 48), OCTAL_8((n) + 56)
+
+static const char octal_digits[512][3] = {
+	OCTAL_64(0), OCTAL_64(64), OCTAL_64(128), OCTAL_64(192), OCTAL_64(256), OCTAL_64(320), OCTAL_64(384), OCTAL_64(448)
+};
+
+#undef OCTAL_64
+#undef OCTAL_8
+#undef OCTAL_ENTRY
+
+
+
+void output_number(TextBuffer *out, int value, int width)
+{
+	char digits[MAX_DECIMAL_DIGITS];
+	int len = 0;
+	char *dest;
+	
+	/* The digits, from the last one */
+	do {
+		digits[len++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	
+	if (width < len)
+		width = len;
+	
+	dest = text_buffer_extend(out, width);
+	memset(dest, '0', width - len);
+	for (dest += width - len; len > 0; dest++)
+		*dest = digits[--len];
+}
+
+
+
+void output_octal_word(char *dest, unsigned int word)
+{
+	memcpy(dest, octal_digits[(word >> 9) & 077] + 1, 2);
+	memcpy(dest + 2, octal_digits[word & 0777], 3);
+}
+
+
+
+void output_word(TextBuffer *out, int address, unsigned int word)
+{
+	char *dest;
+	
+	output_number(out, address, ADDRESS_WIDTH);
+	
+	dest = text_buffer_extend(out, OCTAL_WORD_WIDTH + 2);
+	dest[0] = ' ';
+	output_octal_word(dest + 1, word);
+	dest[OCTAL_WORD_WIDTH + 1] = NEW_LINE;
+}
+
+
+
+long output_word_offset(int first_address, int address)
+{
+	long offset = 0, limit = 1;
+	int width;
+	
+	/* The lines of the addresses below 10^ADDRESS_WIDTH are all of the same length, every further digit makes them one character longer */
+	for (width = 0; width < ADDRESS_WIDTH; width++)
+		limit *= 10;
+	
+	for (; first_address < address; width++, limit *= 10)
+	{
+		if (first_address >= limit)
+			continue;
+		
+		offset += ((address < limit ? address : limit) - first_address) * (long)(width + OCTAL_WORD_WIDTH + 2);
+		first_address = address < limit ? address : (int)limit;
+	}
+	
+	return offset;
+}
+
+
+
+void output_label(TextBuffer *out, const char *name, int address)
+{
+	text_buffer_append(out, name, (int)strlen(name));
+	text_buffer_append(out, " ", 1);
+	output_number(out, address, ADDRESS_WIDTH);
+	text_buffer_append(out, "\n", 1);
+}
+
+
+
+void output_section(TextBuffer *out, const char *name, const char *data, int length)
+{
+	text_buffer_append(out, name, (int)strlen(name));
+	text_buffer_append(out, " ", 1);
+	output_number(out, length, 1);
+	text_buffer_append(out, "\n", 1);
+	if (length > 0)
+		text_buffer_append(out, data, length);
+}
+
+
+
+/* Reads a number followed by the end character, from the position *i of the text. Returns -1 if there is no such number */
+static long read_number(const char *text, int length, int *i, char end)
+{
+	long num = 0;
+	int start = *i;
+	
+	while (*i < length && text[*i] >= '0' && text[*i] <= '9' && num < 0x7FFFFFFFL / 10)
+		num = num * 10 + (text[(*i)++] - '0');
+	
+	if (*i == start || *i >= length || text[*i] != end)
+		return -1;
+	
+	(*i)++;
+	return num;
+}
+
+
+
+int next_output_section(const char *text, int length, int *i, char name[MAX_SECTION_NAME], const char **data, int *data_length)
+{
+	int start;
+	long len;
+	
+	for (start = *i; *i < length && text[*i] != ' ' && *i - start < MAX_SECTION_NAME - 1; (*i)++)
+		;
+	memcpy(name, text + start, *i - start);
+	name[*i - start] = EOS;
+	
+	if (*i == length || text[*i] != ' ')
+		return ERROR;
+	(*i)++;
+	
+	len = read_number(text, length, i, '\n');
+	if (len < 0 || len > length - *i)
+		return ERROR;
+	
+	*data = text + *i;
+	*data_length = (int)len;
+	*i += (int)len;
+	
+	return SUCCESS;
+}
+
+
+
+int write_all(int fd, const char *data, size_t length)
+{
+	ssize_t written;
+	
+	while (length > 0)
+	{
+		written = write(fd, data, length);
+		if (written <= 0)
+		{
+			if (written == -1 && errno == EINTR)
+				continue;
+			return ERROR;
+		}
+		data += written;
+		length -= written;
+	}
+	
+	return SUCCESS;
+}
+
+
+
+/* Returns 1 if the file exists and holds exactly the given content, 0 otherwise */
+static int file_has_content(const char *name_file, const char *data, int length)
+{
+	char block[COMPARE_BLOCK_SIZE];
+	struct stat info;
+	int fd, len, same = 1;
+	
+	fd = open(name_file, O_RDONLY);
+	if (fd == -1)
+		return 0;
+	
+	/* Files of another size are not read at all */
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size != length)
+	{
+		close(fd);
+		return 0;
+	}
+	
+	while (same && length > 0 && (len = (int)read(fd, block, length < COMPARE_BLOCK_SIZE ? length : COMPARE_BLOCK_SIZE)) > 0)
+	{
+		same = memcmp(block, data, len) == 0;
+		data += len;
+		length -= len;
+	}
+	
+	close(fd);
+	
+	return same && length == 0;
+}
+
+
+
+/* The umask of the process, read once */
+static mode_t process_umask;
+static pthread_once_t umask_once = PTHREAD_ONCE_INIT;
+
+
+
+static void read_umask(void)
+{
+	/* The umask can only be read by setting it, so it is set back right away */
+	process_umask = umask(0);
+	umask(process_umask);
+}
+
+
+
+void output_init(void)
+{
+	pthread_once(&umask_once, read_umask);
+}
+
+
+
+int write_output_file(const char *name_file, const char *extension, const char *data, int length, Diagnostics *diagnostics)
+{
+	char *full_name_file, *temp_name_file;
+	int fd, result = SUCCESS;
+	
+	if (strcmp(name_file, STREAM_NAME) == 0)
+		return SUCCESS;
+	
+	full_name_file = generate_full_name(name_file, extension);
+	
+	/* A file that already holds the content is left as it is, so that its modification time does not change */
+	if (file_has_content(full_name_file, data, length))
+	{
+		memory_free(full_name_file);
+		return SUCCESS;
+	}
+	
+	/* The temporary file has a unique name, so that runs that write the same file at the same time do not share it */
+	temp_name_file = generate_full_name(full_name_file, TEMP_SUFFIX);
+	
+	/* Write the content to the temporary file */
+	fd = mkstemp(temp_name_file);
+	if (fd == -1)
+	{
+		report(diagnostics, "Error! The file %s cannot be opened for writing\n", temp_name_file);
+		memory_free(temp_name_file);
+		memory_free(full_name_file);
+		return ERROR;
+	}
+	
+	result = write_all(fd, data, length);
+	output_init();
+	if (fchmod(fd, OUTPUT_FILE_MODE & ~process_umask) != 0)
+		result = ERROR;
+	
+	/* Replace the file with the complete temporary file */
+	if (close(fd) != 0 || result == ERROR || rename(temp_name_file, full_name_file) != 0)
+	{
+		report(diagnostics, "Error! The file %s cannot be written\n", full_name_file);
+		unlink(temp_name_file);
+		result = ERROR;
+	}
+	
+	memory_free(temp_name_file);
+	memory_free(full_name_file);
+	
+	return result;
+}
@@ -0,0 +1,152 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+#include "text_buffer.h"
+#include "diagnostics.h"
+
+
+#define ADDRESS_WIDTH 4 /* Addresses are written in decimal with at least 4 digits, including leading zeros */
+#define OCTAL_WORD_WIDTH 5 /* A 15-bit word is written in octal with 5 digits */
+#define STREAM_NAME "-" /* The name that stands for a source read from the standard input, whose output files are written to streams */
+#define MAX_SECTION_NAME 16 /* The longest name of a section, including the null terminator */
+
+
+/*
+ * Several output files can be kept together (in an entry of the build cache, or in the multiplexed stream of a source
+ * that is read from the standard input) as a series of sections, each one holding a file:
+ *
+ *     <name> <length>\n<content>
+ *
+ * The name of a section is the extension of its file (".ob", ".ent", ".ext" or ".am"), or "messages".
+ */
+
+
+
+/**
+ * Appends a non-negative number in decimal to a buffer, with leading zeros up to a minimum width (as "%0*d").
+ *
+ * @param out The buffer to append to.
+ * @param value The number, it must not be negative.
+ * @param width The minimum number of digits.
+ */
+void output_number(TextBuffer *out, int value, int width);
+
+
+
+/**
+ * Appends a line of the object file to a buffer: the address in decimal with 4 digits, a space,
+ * and the word in octal with 5 digits (as "%04d %05o\n"). The octal digits are taken from a precomputed table.
+ *
+ * @param out The buffer to append to.
+ * @param address The address of the word.
+ * @param word The 15-bit word.
+ */
+void output_word(TextBuffer *out, int address, unsigned int word);
+
+
+
+/**
+ * Writes a 15-bit word in octal with 5 digits, as in a line of the object file (not null-terminated).
+ *
+ * @param dest The place of the 5 digits.
+ * @param word The 15-bit word.
+ */
+void output_octal_word(char *dest, unsigned int word);
+
+
+
+/**
+ * Returns the position of the line of a word in a run of object file lines (see output_word) of consecutive addresses.
+ * The lines are of the same length as long as the addresses have at most 4 digits, so the position is computed, not searched.
+ *
+ * @param first_address The address of the first line of the run.
+ * @param address The address of the word, not below first_address.
+ * @return The number of characters before the line of the word.
+ */
+long output_word_offset(int first_address, int address);
+
+
+
+/**
+ * Appends a line of the entries or externals file to a buffer: a label name, a space, and an address
+ * in decimal with 4 digits (as "%s %04d\n").
+ *
+ * @param out The buffer to append to.
+ * @param name The name of the label.
+ * @param address The address.
+ */
+void output_label(TextBuffer *out, const char *name, int address);
+
+
+
+/**
+ * Appends a section to a buffer of sections.
+ *
+ * @param out The buffer to append to.
+ * @param name The name of the section.
+ * @param data The content of the section.
+ * @param length The length of the content.
+ */
+void output_section(TextBuffer *out, const char *name, const char *data, int length);
+
+
+
+/**
+ * Reads the section that starts at position *i of a buffer of sections, and moves *i to the next section.
+ * The content is not copied, it points into the buffer.
+ *
+ * @param text The buffer of sections.
+ * @param length The length of the buffer.
+ * @param i The position of the section, it must be before the end of the buffer.
+ * @param name The buffer for the name of the section (null-terminated).
+ * @param data A pointer to the content of the section.
+ * @param data_length A pointer to the length of the content.
+ * @return SUCCESS if the section is complete, ERROR if the buffer does not hold a valid section at this position.
+ */
+int next_output_section(const char *text, int length, int *i, char name[MAX_SECTION_NAME], const char **data, int *data_length);
+
+
+
+/**
+ * Writes all the bytes to a file descriptor, writing again after a write that is cut short.
+ *
+ * @param fd The file descriptor.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @return SUCCESS if all the bytes were written, ERROR otherwise.
+ */
+int write_all(int fd, const char *data, size_t length);
+
+
+
+/**
+ * Reads the umask of the process, which write_output_file applies to the permissions of the files it writes.
+ * Reading the umask sets it for a moment, so it is called at the start of main, before any thread is started
+ * (a later call does nothing).
+ */
+void output_init(void);
+
+
+
+/**
+ * Writes an output file at once: the content is written with one write call to a temporary file next to it,
+ * with a unique name (mkstemp) and the permissions that open would give it (0666 without the umask),
+ * which is then renamed to the file name, so that a file with this name is always either the old file or the complete new one.
+ * A file that already holds exactly this content is not written again, so that its modification time is kept.
+ * If the file cannot be written, an error message is reported and the temporary file is removed.
+ * The files of a source that is read from the standard input (named STREAM_NAME) are not written, the driver writes
+ * them to their streams from the recorded outputs of the context.
+ *
+ * @param name_file The base name of the file (without extension).
+ * @param extension The extension of the file (e.g., ".ob").
+ * @param data The content of the file.
+ * @param length The length of the content.
+ * @param diagnostics The buffer that an error is reported to.
+ * @return SUCCESS if the file holds the content, ERROR if it could not be written.
+ */
+int write_output_file(const char *name_file, const char *extension, const char *data, int length, Diagnostics *diagnostics);
+
+
+
+#endif
@@ -1,48 +1,67 @@
 #include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
 #include "utils_and_checks.h"
-#include "macro.h"
-#include "first_pass.h"
-#include "second_pass.h"
+#include "driver.h"
+#include "server.h"
+#include "lexer.h"
+#include "output.h"
 
 
 
 int main(int argc, char *argv[])
 {
-	int i, has_errors = 0;
-	node *head_macro_list = NULL; /* empty list */
-	node *head_symbols_list = NULL;
-	node *head_instructions_list = NULL;
-	node *head_data_list = NULL;
-
-
-	for (i = 1; i < argc; i++)/*Iterate over each file passed as an argument*/
+	int i, num_files, num_failed;
+	AssemblerOptions options;
+	const char *socket_path;
+	
+	
+	/* The reserved words of the lexer are a table built by hand, which must agree with the instruction set */
+	if (lexer_check_keywords() == ERROR)
+	{
+		printf("Error! The reserved words of the lexer do not match the instruction set (isa.h)\n");
+		return 1;
+	}
+	
+	/* Before any thread is started */
+	output_init();
+	
+	
+	/* With --connect, the rest of the command line is forwarded to a running server, which assembles the files */
+	for (i = 1; i < argc; i++)
 	{
-		if (macro_analyze(argv[i], &head_macro_list) == ERROR)
-			has_errors = 1;
-		
-		has_errors = first_pass_analyze(argv[i], &head_symbols_list, &head_data_list, &head_instructions_list);
-		
-		if (check_macro_symbol_conflict(head_macro_list, head_symbols_list) == ERROR)
-			has_errors = 1;
-		
-		if (second_pass_analyze(argv[i], &head_instructions_list, &head_data_list, &head_symbols_list, has_errors) == ERROR)
-			has_errors = 1;
-		
-		if (has_errors)
-			printf("Errors were detected and therefore no output files are generated, sorry:(\n");
+		if (strcmp(argv[i], "--connect") == 0)
+		{
+			if (i + 1 == argc)
+			{
+				printf("Error! The option --connect expects a socket path\n");
+				return 1;
+			}
 			
-
-		free_list(&head_macro_list, delete_macro_node);
-		free_list(&head_symbols_list, delete_code_node);
-		free_list(&head_instructions_list, delete_code_node);
-		free_list(&head_data_list, delete_symbol_node);
-
+			socket_path = argv[i + 1];
+			memmove(argv + i, argv + i + 2, (argc - i - 2) * sizeof(char *));
+			return run_client(socket_path, argc - 3, argv + 1) == ERROR;
+		}
 	}
-
-
-	return 0;
+	
+	
+	/* Separate the options from the names of the source files, the names are kept at the start of argv */
+	num_files = parse_options(argc - 1, argv + 1, &options, stdout);
+	if (num_files == ERROR)
+		return 1;
+	
+	if (options.server_path != NULL)
+	{
+		if (num_files > 0)
+		{
+			printf("Error! The option --server does not take source files, they are sent by the clients\n");
+			return 1;
+		}
+		return run_server(options.server_path, &options) == ERROR;
+	}
+	
+	/* The standard output of a run that reads a source from the standard input carries its object file */
+	num_failed = assemble_files(argv + 1, num_files, &options, count_stream_sources(argv + 1, num_files) > 0 ? stderr : stdout);
+	
+	/* A build that runs the assembler sees that a file had errors */
+	return num_failed > 0;
 }
-
-
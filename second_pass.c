@@ -2,200 +2,185 @@
 #include "first_pass.h"
 #include "utils_and_checks.h"
 #include "linked_list.h"
+#include "output.h"
+#include "object_file.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 
-/* External declaration of global variables IC and DC, defined in another file */
-extern int IC;
-extern int DC;
 
 
-
-int second_pass_analyze(char *name_file, node **head_instructions_list, node **head_data_list, node **head_symbols_list, int has_errors)
+int second_pass_analyze(char *name_file, AssemblyContext *ctx, int has_errors)
 {
-	node *head_extern_symbols = NULL;
+	List extern_symbols_list;
 	int error_flag = has_errors;
+	double start = stats_stage_start();
 	
+	list_init(&extern_symbols_list);
 	
-	/* Merge entry labels with their corresponding definitions. If an error occurs, mark it in the error flag */
-	if (merge_entry_labels(head_symbols_list) == ERROR)
-		error_flag = 1;
-	
-	
-	/* check if any label is marked as both `entry` and `extern`. If an error occurs, mark it in the error flag */
-	if (check_entry_extern_conflict(*head_symbols_list) == ERROR)
 	
+	/* Check that every entry label is defined. If an error occurs, mark it in the error flag 
+	   (duplicate labels and entry/extern conflicts were already detected when the labels were added to the symbol table) */
+	if (merge_entry_labels(&ctx->symbols) == ERROR)
 		error_flag = 1;
-		
-	/* Check for 2 labels with the same name. If duplicates are found, mark the error */
-	if (check_duplicate_labels(*head_symbols_list) == ERROR)
-        	error_flag = 1;
+	stats_stage_end(&ctx->stats, STAGE_MERGE_ENTRY_LABELS, start);
         
         
         /* Update code words with symbol addresses. If an error occurs, mark it */
-        if (update_code_words(head_instructions_list, head_symbols_list, &head_extern_symbols) == ERROR)
+        start = stats_stage_start();
+        if (update_code_words(ctx, &extern_symbols_list) == ERROR)
         	error_flag = 1;
+        stats_stage_end(&ctx->stats, STAGE_UPDATE_CODE_WORDS, start);
         
         
         
         /*  If any errors are found during the first or the second pass, return ERROR */			
         if (error_flag)
-        	return ERROR;	
+        {
+        	free_list(&extern_symbols_list, NULL);
+        	return ERROR;
+        }
         /* Generate output files only if no errors are found */
         else 
         {
-        	create_object_file(name_file, *head_instructions_list, *head_data_list);
+        	start = stats_stage_start();
+        	if (create_object_file(name_file, ctx, &extern_symbols_list) == ERROR)
+        		error_flag = 1;
+        	if (ctx->record_outputs)
+        		output_section(&ctx->outputs, object_extension(ctx->object_format), ctx->output.text, ctx->output.length);
+        	stats_stage_end(&ctx->stats, STAGE_CREATE_OBJECT_FILE, start);
         	
         	/* If there are entry labels - creating a entry file */
-        	if (count_entry_symbols(*head_symbols_list) > 0) /* Count entry symbols */
-			create_entry_files(name_file, *head_symbols_list);
+        	start = stats_stage_start();
+		if (create_entry_files(name_file, &ctx->symbols, ctx->IC, &ctx->output, &ctx->diagnostics) == ERROR)
+			error_flag = 1;
+		if (ctx->record_outputs && ctx->output.length > 0)
+			output_section(&ctx->outputs, ".ent", ctx->output.text, ctx->output.length);
 		
 		
 		/* If there are extern labels - creating a extern file */	
-		if (head_extern_symbols != NULL) 
-			create_extern_files(name_file, head_extern_symbols);
+		if (ctx->bounded_memory)
+		{
+			if ((extern_symbols_list.count > 0 || staging_length(&ctx->staged_externals) > 0) &&
+				create_staged_extern_file(name_file, ctx, &extern_symbols_list) == ERROR)
+				error_flag = 1;
+		}
+		else if (extern_symbols_list.count > 0) 
+		{
+			if (create_extern_files(name_file, &extern_symbols_list, &ctx->output, &ctx->diagnostics) == ERROR)
+				error_flag = 1;
+			if (ctx->record_outputs)
+				output_section(&ctx->outputs, ".ext", ctx->output.text, ctx->output.length);
+		}
+		stats_stage_end(&ctx->stats, STAGE_CREATE_OTHER_FILES, start);
 	}
 
 
-	free_list(&head_extern_symbols, delete_extern_symbol_node);
-	return SUCCESS;
+	free_list(&extern_symbols_list, NULL);
+	return error_flag ? ERROR : SUCCESS;
 }
 
 
 
-int merge_entry_labels(node **head_symbols_list) 
+int merge_entry_labels(SymbolTable *symbols) 
 {
-	node *temp1 = *head_symbols_list;
-	node *temp2;
-	node *to_delete;
-	node *prev1 = NULL; /* To keep track of the previous node for deletion */
-	char *symbol_name;
-	SymbolNode *symbol_data1, *symbol_data2;
+	int i, error_flag = 0;
+	SymbolNode *symbol_data;
 
 
-	/* IterateTraverse through the symbol list */
-	while (temp1 != NULL) 
+	/* Iterate through the symbol table */
+	for (i = 0; i < symbols->count; i++)
 	{
-		symbol_data1 = (SymbolNode *)(temp1->data);
-        
-		if (symbol_data1->is_entry && symbol_data1->adress == TEMP_ENTRY_ADDRESS) 
-        	{
-            		symbol_name = symbol_data1->name;
-            		temp2 = *head_symbols_list;           
-
-			/* IterateTraverse through the symbol list */
-            		while (temp2 != NULL) 
-            		{
-                		symbol_data2 = (SymbolNode *)(temp2->data);
-                
-                		/* If matching label found, mark it as entry */
-                		if (strcmp(symbol_data2->name, symbol_name) == 0 && !symbol_data2->is_entry) 
-                		{
-                    			symbol_data2->is_entry = 1; /* Mark the label as entry */
-                    			break;
-                		}
-                		temp2 = (node *)temp2->next;
-            		}
-            
-            		/* If no corresponding symbol found, handle the error */
-            		if (temp2 == NULL)
-            		{
-                		printf("Error in line number %d: Entry label '%s' is not defined in the current source file.\n", symbol_data1->line_num, symbol_name);
-                		return ERROR;
-                	}
-                	/*Delete temp1 node if found */
-                	else
-                	{
-                		if (prev1 == NULL) 
-                    			*head_symbols_list = (node *)temp1->next; /* Remove head */
-                		else 
-                    			prev1->next = temp1->next; /* Bypass temp1 node */
-                		to_delete = temp1;
-                		temp1 = (node *)temp1->next; /* Move to next node */
-                		free(to_delete->data);
-                		free(to_delete);
-                		continue; /* Skip temp1 update at the end of the loop */
-            		}
+		symbol_data = &symbols->symbols[i];
+		
+		/* An entry label that was never defined in the current source file is an error */
+		if (symbol_data->is_entry && !symbol_data->is_defined)
+		{
+			report(symbols->diagnostics, "Error in line number %d: Entry label '%s' is not defined in the current source file.\n", symbol_data->entry_line_num, symbol_data->name);
+			error_flag = 1;
 		}
-        	else 
-			prev1 = temp1; /* Move prev1 forward for non-entry nodes */
-			
-        	temp1 = (node *)temp1->next;
 	}
 	
-	return SUCCESS;
+	return error_flag ? ERROR : SUCCESS;
+}
+
+
+
+/* Orders the fixups by their words, the free fixups last */
+static int compare_fixups(const void *a, const void *b)
+{
+	const Fixup *fixup_a = (const Fixup *)a, *fixup_b = (const Fixup *)b;
+	
+	if ((fixup_a->symbol == -1) != (fixup_b->symbol == -1))
+		return fixup_a->symbol == -1 ? 1 : -1;
+	
+	return fixup_a->word - fixup_b->word;
+}
+
+
+
+/* With bounded memory, moves the fixups of the words that still wait for labels to the start of the array,
+   in the order of the instructions, and returns their number */
+static int sort_waiting_fixups(AssemblyContext *ctx)
+{
+	int i, count = 0;
+	
+	for (i = 0; i < ctx->num_fixups; i++)
+		if (ctx->fixups[i].symbol != -1)
+			count++;
+	
+	if (count > 0)
+		qsort(ctx->fixups, ctx->num_fixups, sizeof(Fixup), compare_fixups);
+	
+	return count;
 }
 
 
 
-int update_code_words(node **head_instructions_list, node **head_symbols_list, node **head_extern_symbols)
+int update_code_words(AssemblyContext *ctx, List *extern_symbols_list)
 {
-	node *temp1 = *head_instructions_list;
-	node *temp2;
-	CodeNode *instruction_data;
+	int i, num_fixups = ctx->num_fixups;
+	Fixup *fixup;
 	SymbolNode *symbol_data;
-	char *symbol_name;
-	char *adress_in_binary;
+	uint16_t code_word;
 	
-	/* Iterate through the instructions list */
-	while (temp1 != NULL)
-	{
-		instruction_data = (CodeNode *)(temp1->data);
+	/* With bounded memory, the other words were already completed in the first pass */
+	if (ctx->bounded_memory)
+		num_fixups = sort_waiting_fixups(ctx);
 	
-		/* Check if the code word does not start with '0' or '1', indicating a label name */
-		if ((instruction_data -> code_word)[0] != '0' && (instruction_data -> code_word)[0] != '1')
+	/* Only the words that wait for the address of a label are visited, in the order of the instructions */
+	for (i = 0; i < num_fixups; i++)
+	{
+		fixup = &ctx->fixups[i];
+		symbol_data = &ctx->symbols.symbols[fixup->symbol];
+		
+		/* If the label is not defined (it was only used as an operand, or mentioned in '.entry'), report an error and return ERROR */
+		if (!symbol_data->is_defined && !symbol_data->is_extern)
 		{
-			symbol_name = instruction_data -> code_word;
-			temp2 = *head_symbols_list;
+			report(&ctx->diagnostics, "Error in line number %d: Using an undefined label\n", fixup->line_num);
+			return ERROR;
+		}
+		
+		/* Store the symbol address in bits 3-14 of the code word (the data section starts at the final IC) */
+		code_word = (uint16_t)((symbol_address(symbol_data, ctx->IC) & OPERAND_MASK) << ARE_BITS);
+		
+		/* Set the ARE field based on whether the symbol is external or not */
+		if (symbol_data -> is_extern)
+		{
+			code_word |= ARE_EXTERNAL;
 			
-			/* Iterate through the symbols list */
-			while (temp2 != NULL) 
-            		{
-                		symbol_data = (SymbolNode *)(temp2->data);
-                		
-                		/* Check if the symbol name matches */
-                		if (strcmp(symbol_name, symbol_data -> name) == 0)
-                		{
-                			/* Convert symbol address to binary and store it in the code word */
-                			adress_in_binary = int_to_binary(symbol_data -> adress, 12);
-                			instruction_data->code_word = (char *)malloc(CODE_WORD_LEN * sizeof(char));
-
-					if (!instruction_data->code_word) 
-					{
-						printf("Allocation failure\n");
-						exit(1);
-					}
-                			strcpy(instruction_data -> code_word, adress_in_binary);
-                			free(adress_in_binary);
-                			
-                			/* Add appropriate suffix based on whether the symbol is external or not */
-                			if (symbol_data -> is_extern)
-                			{
-                				strcat(instruction_data -> code_word, "001");
-                				
-                				/* Save external symbol and address for the external file */
-                				crate_extern_node(head_extern_symbols, symbol_data->name, instruction_data->adress);
-                			}
-                			else
-                				strcat(instruction_data -> code_word, "010");
-                			
-                			break; /* Exit the symbols list iteration */
-                		
-                		}
-                		temp2 = (node *)temp2->next;
-                	}
-                	
-                	/* If no matching symbol is found, print an error and return ERROR */
-                	if (temp2 == NULL)
-                	{
-                		printf("Error in line number %d: Using an undefined label\n", instruction_data->line_num);
-                		return ERROR;
-                	}
+			/* Save external symbol and address for the external file */
+			crate_extern_node(extern_symbols_list, symbol_data->name, MEMORY_START_ADDRESS + fixup->word, &ctx->arena);
 		}
-	
-		temp1 = (node *)temp1->next;
+		else
+			code_word |= ARE_RELOCATABLE;
+		
+		/* With bounded memory, the word is completed as the staged code is copied into the object file */
+		if (ctx->bounded_memory)
+			fixup->next = code_word;
+		else
+			ctx->code.words[fixup->word] = code_word;
 	}
 	
 	
@@ -205,190 +190,207 @@ int update_code_words(node **head_instructions_list, node **head_symbols_list, n
 
 
 
-void crate_extern_node(node **head, char *name, int address)
+void crate_extern_node(List *extern_symbols_list, char *name, int address, Arena *arena)
 {
-	/* Allocate memory for a new data node */
-	ExternSymbolNode *node_data = (ExternSymbolNode *)malloc(sizeof(ExternSymbolNode));
-    
-	if (!node_data)
-	{
-        	printf("Allocation failure\n");
-        	exit(1);
-	}
+	/* Allocate a new data node from the arena */
+	ExternSymbolNode *node_data = (ExternSymbolNode *)arena_alloc(arena, sizeof(ExternSymbolNode));
     
 	/* Initialize the data node with the provided values */
 	node_data->name = name;
 	node_data->address = address;
 
 	/* Add the node to the end of the data linked list */
-	add_node_end(head,(void *)node_data, delete_extern_symbol_node);
+	add_node_end(extern_symbols_list, (void *)node_data);
 }
 
 
 
-void create_object_file(char *name_file, node *head_instructions_list, node *head_data_list)
+/* With bounded memory, writes the object file from the staged words: the header, the lines of the instruction words
+   as they were staged, and a line for every staged data word. The words that waited for labels until the second pass
+   are completed on the way, from their fixups (in the order of the instructions, see update_code_words).
+   The file is written to a staging file that then replaces it */
+static int create_staged_object_file(char *name_file, AssemblyContext *ctx)
 {
-	node *temp = head_instructions_list;
-	CodeNode *instruction_data;
-	CodeNode *data_data;
-	int adress;
-	char code_word_in_octal[6]; /* 5 digits + null terminator */
-	FILE *f;
-
-	/* Initialize object file */
-	init_file(&f, name_file, ".ob", "w");
-
-	/* Write the header to the object file */
-	fprintf(f, " %d %d\n", IC-100, DC); /* -100 because IC will be initialized to 100 - the address from which you can write to the memory */
-
-
-	/* Write the instruction section */
-	temp = head_instructions_list;
-	while (temp != NULL)
+	StagingFile object;
+	char block[STAGING_BLOCK_SIZE], digits[OCTAL_WORD_WIDTH];
+	uint16_t words[STAGING_BLOCK_SIZE / sizeof(uint16_t)];
+	int i, len, header, fixup = 0, address = ctx->IC;
+	long copied = 0, position;
+	
+	staging_init(&object);
+	if (staging_rewind(&ctx->staged_code, &ctx->diagnostics) == ERROR || staging_rewind(&ctx->staged_data, &ctx->diagnostics) == ERROR ||
+		staging_open(&object, name_file, ".ob.tmp", &ctx->diagnostics) == ERROR)
+		return ERROR;
+	
+	object_format_text_header(ctx->IC - MEMORY_START_ADDRESS, ctx->DC, &object.buffer);
+	header = object.buffer.length;
+	
+	while ((len = staging_read(&ctx->staged_code, block, sizeof(block))) > 0)
 	{
-		instruction_data = (CodeNode *)(temp->data);
-        	adress = instruction_data->adress;
-        	fprintf(f, "%04d ", adress);
-
-        	binary_to_octal(instruction_data->code_word, code_word_in_octal); /* Convert binary code word to octal */
-        	fprintf(f, "%s\n", code_word_in_octal);
-
-        	temp = (node *)temp->next;
+		text_buffer_append(&object.buffer, block, len);
+		copied += len;
+		
+		/* The octal digits of a word end its line, right before its '\n' character */
+		for (; fixup < ctx->num_fixups && ctx->fixups[fixup].symbol != -1; fixup++)
+		{
+			position = output_word_offset(MEMORY_START_ADDRESS, MEMORY_START_ADDRESS + ctx->fixups[fixup].word + 1) - OCTAL_WORD_WIDTH - 1;
+			if (position + OCTAL_WORD_WIDTH > copied)
+				break;
+			
+			output_octal_word(digits, (unsigned int)ctx->fixups[fixup].next);
+			staging_overwrite(&object, header + position, digits, OCTAL_WORD_WIDTH);
+		}
+		
+		staging_spill(&object);
 	}
-
-
-    	/* Write the data section */
-    	temp = head_data_list;
-    	while (temp != NULL)
-    	{
-        	data_data = (CodeNode *)(temp->data);
-        	adress = data_data->adress;
-        	fprintf(f, "%04d ", adress);
-
-        	binary_to_octal(data_data->code_word, code_word_in_octal); /*  Convert binary data to octal */
-        	fprintf(f, "%s\n", code_word_in_octal);
-
-        	temp = (node *)temp->next;
-    	}
-
-
-    	/* Close the object file */
-    	fclose(f);
-}
-
-
-
-
-void binary_to_octal(const char *binary, char *octal) 
-{
-	int decimal = 0;
-	int power = 1;
-	int i;
-    
-	/* Convert the binary string to a decimal number */
-	for (i = 14; i >= 0; --i) 
+	
+	/* The data section starts right after the instructions */
+	while ((len = staging_read(&ctx->staged_data, (char *)words, sizeof(words))) > 0)
 	{
-        	if (binary[i] == '1')
-            		decimal += power;
-            		
-        	power *= 2;
+		for (i = 0; i < len / (int)sizeof(uint16_t); i++)
+			output_word(&object.buffer, address++, words[i]);
+		staging_spill(&object);
 	}
-
-	/* Convert the decimal number to an octal string with 5 digits including leading zeros */
-	sprintf(octal, "%05o", decimal);
+	
+	return staging_keep(&object, name_file, ".ob", &ctx->diagnostics);
 }
 
 
 
-int count_entry_symbols(node *head_symbols_list)
+int create_object_file(char *name_file, AssemblyContext *ctx, List *extern_symbols_list)
 {
-	int count_is_entry = 0;
-	node *temp = head_symbols_list;
+	int i;
+	ObjectImage image;
 	SymbolNode *symbol_data;
-    
-	/* Iterate through the symbols list */
-	while (temp != NULL)
+	node *temp;
+	
+	if (ctx->bounded_memory)
+		return create_staged_object_file(name_file, ctx);
+
+	/* The image is a view of the words of the context, the data section starts at the final IC */
+	object_image_init(&image);
+	image.code = ctx->code.words;
+	image.code_count = ctx->code.count;
+	image.data = ctx->data.words;
+	image.data_count = ctx->data.count;
+	image.base_address = MEMORY_START_ADDRESS;
+
+	if (ctx->object_format == OBJECT_TEXT)
+		object_format_text(&image, &ctx->output);
+	else
 	{
-        	symbol_data = (SymbolNode *)(temp->data);
-        
-        	/* Check if the symbol is extern */    
-        	if (symbol_data -> is_entry)
-            		count_is_entry++;
-            
-        	temp = (node *)temp->next;
+		/* The binary file carries the entry labels, in the order of their definition, and the extern references */
+		for (i = 0; i < ctx->symbols.num_defined; i++)
+		{
+			symbol_data = &ctx->symbols.symbols[ctx->symbols.defined_order[i]];
+			if (symbol_data->is_entry)
+				object_add_record(&image, 0, symbol_data->name, symbol_address(symbol_data, ctx->IC));
+		}
+
+		for (temp = extern_symbols_list->head; temp != NULL; temp = temp->next)
+			object_add_record(&image, 1, ((ExternSymbolNode *)temp->data)->name, ((ExternSymbolNode *)temp->data)->address);
+
+		object_format_binary(&image, &ctx->output);
+		object_image_free(&image);
 	}
-    
-	return count_is_entry; /* Return the total count of extern symbols */
+
+    	/* Write the object file */
+	return write_output_file(name_file, object_extension(ctx->object_format), ctx->output.text, ctx->output.length, &ctx->diagnostics);
 }
 
 
 
-void create_entry_files(char *name_file, node *head_symbols_list)
+int create_entry_files(char *name_file, SymbolTable *symbols, int data_base, TextBuffer *out, Diagnostics *diagnostics)
 {
-	node *temp = head_symbols_list;
+	int i;
 	SymbolNode *symbol_data;
-	FILE *f;
 	
-	/* Initialize object file */
-	init_file(&f, name_file, ".ent", "w");
+	out->length = 0;
 	
-	
-	/* Iterate through the symbols list */
-	while (temp != NULL)
+	/* Iterate through the symbols in the order of their definition */
+	for (i = 0; i < symbols->num_defined; i++)
 	{
-		symbol_data = (SymbolNode *)(temp->data);
+		symbol_data = &symbols->symbols[symbols->defined_order[i]];
 	
 		/* Check if the symbol is marked as entry */
 		if (symbol_data -> is_entry)
-		{
-			fprintf(f, "%s ", symbol_data -> name);
-			fprintf(f, "%04d\n", symbol_data -> adress);
-				
-		}
-			
-		temp = (node *)temp->next;
+			output_label(out, symbol_data -> name, symbol_address(symbol_data, data_base));
 	}
 	
 		
-	/* Close the entries file */	
-	fclose(f);
+	/* The file is created only if there are entry labels */	
+	if (out->length > 0)
+		return write_output_file(name_file, ".ent", out->text, out->length, diagnostics);
+	
+	return SUCCESS;
 }
 
 
 
-void create_extern_files(char *name_file, node *head_extern_symbols)
+int create_extern_files(char *name_file, List *extern_symbols_list, TextBuffer *out, Diagnostics *diagnostics)
 {
-	node *temp = head_extern_symbols;
+	node *temp = extern_symbols_list->head;
 	ExternSymbolNode *extern_data;
-	FILE *f;
 
-	/* Initialize object file */
-	init_file(&f, name_file, ".ext", "w");
+	out->length = 0;
 	
-	/* Iterate through the extern symbols list and write each symbol and address to the file */
+	/* Iterate through the extern symbols list and write each symbol and address to the buffer */
 	while (temp != NULL)
 	{
         	extern_data = (ExternSymbolNode *)(temp->data);
         	
         	/* Write the symbol name and its address */
-        	fprintf(f, "%s %04d\n", extern_data->name, extern_data->address);
+        	output_label(out, extern_data->name, extern_data->address);
         	
-        	temp = (node *)temp->next;
+        	temp = temp->next;
 	}
 	
 
-	/* Close the external file */	
-	fclose(f);
+	/* Write the external file */	
+	return write_output_file(name_file, ".ext", out->text, out->length, diagnostics);
 }
 
 
 
-void delete_extern_symbol_node(void *e)
+int create_staged_extern_file(char *name_file, AssemblyContext *ctx, List *extern_symbols_list)
 {
-	ExternSymbolNode *data_ext_symbol_node = (ExternSymbolNode *)e;
-	free(data_ext_symbol_node);
+	StagingFile externals;
+	StagedExtern references[STAGING_BLOCK_SIZE / sizeof(StagedExtern)];
+	node *temp = extern_symbols_list->head;
+	ExternSymbolNode *extern_data;
+	int i = 0, count = 0;
+	
+	staging_init(&externals);
+	if (staging_rewind(&ctx->staged_externals, &ctx->diagnostics) == ERROR || 
+		staging_open(&externals, name_file, ".ext.tmp", &ctx->diagnostics) == ERROR)
+		return ERROR;
+	
+	/* Both the staged references and the list are in the order of the words, so they are merged */
+	for (;;)
+	{
+		if (i == count)
+		{
+			count = staging_read(&ctx->staged_externals, (char *)references, sizeof(references)) / (int)sizeof(StagedExtern);
+			i = 0;
+		}
+		
+		extern_data = temp != NULL ? (ExternSymbolNode *)temp->data : NULL;
+		
+		if (i < count && (extern_data == NULL || references[i].address < extern_data->address))
+		{
+			output_label(&externals.buffer, ctx->symbols.symbols[references[i].symbol].name, references[i].address);
+			i++;
+		}
+		else if (extern_data != NULL)
+		{
+			output_label(&externals.buffer, extern_data->name, extern_data->address);
+			temp = temp->next;
+		}
+		else
+			break;
+		
+		staging_spill(&externals);
+	}
+	
+	return staging_keep(&externals, name_file, ".ext", &ctx->diagnostics);
 }
-
-
-
-
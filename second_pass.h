@@ -3,6 +3,9 @@
 
 #include "linked_list.h"
 #include "first_pass.h"
+#include "symbol_table.h"
+#include "context.h"
+#include "arena.h"
 
 
 typedef struct ExternSymbol {
@@ -13,10 +16,10 @@ typedef struct ExternSymbol {
 
 
 /**
- * Performs the second pass analysis on the instructions and symbols lists.
+ * Performs the second pass analysis on the code image and the symbol table.
  * 
- * This function iterates through the instructions list and updates the code words
- * with the corresponding addresses from the symbols list.
+ * This function iterates through the words of the code image that wait for labels and updates the code words
+ * with the corresponding addresses from the symbol table.
  * Additionally, it creates an object file with the extension `.ob` where each line
  * contains the address and content of a memory word. If there are external labels, it
  * creates a file with the extension `.ext` where each line contains the name of an 
@@ -25,124 +28,102 @@ typedef struct ExternSymbol {
  * line contains the name of the symbol defined as `entry` and its value as found in the
  * symbol table. Values are represented in decimal format.
  * 
- * @param head_instructions_list Pointer to the head of the instructions list.
- * @param head_data_list Pointer to the head of the data list.
- * @param head_symbols_list Pointer to the head of the symbols list.
  * @param name_file The name of the source file.
+ * @param ctx The assembly context of the file, holding the code image, the data image and the symbol table.
+ * @param has_errors 1 if errors were found before the second pass (no output files are created in this case), 0 otherwise.
  * @return SUCCESS if the analysis is completed successfully, ERROR otherwise.
  */
-int second_pass_analyze(char *name_file, node **head_instructions_list, node **head_data_list, node **head_symbols_list, int has_errors);
+int second_pass_analyze(char *name_file, AssemblyContext *ctx, int has_errors);
 
 
 
 /**
- * Merges entry labels with their corresponding definitions.
+ * Checks that every label marked as `entry` is defined in the current source file.
  * 
- * This function processes the list of symbols to handle labels marked as `entry`.
  * An entry label is one that is defined within the current source file, but is 
  * intended to be used as an operand in instructions found in other source files.
+ * The `.entry` directive marks the label in the symbol table whether it appears before
+ * or after the definition of the label, so all that is left is to find the entry labels
+ * that were never defined. For each one of them an error message is reported.
  * 
- * For each label marked as `entry`, the function searches the symbol list for 
- * a label with the same name. If a matching label is found that is not marked 
- * as `entry`, it updates the matching label to be an entry label and deletes the 
- * original entry label. If no matching label is found, an error message is printed 
- * indicating that the entry label is not defined.
- * 
- * The function also removes the original entry label from the list after it has 
- * been merged with the corresponding label, if applicable.
- * 
- * @param head_symbols_list A double pointer to the head of the symbol list.
- * @return SUCCESS if the analysis is completed successfully, ERROR otherwise.
+ * @param symbols The symbol table, the error messages are reported to its diagnostics.
+ * @return SUCCESS if all the entry labels are defined, ERROR otherwise.
  */
-int merge_entry_labels(node **head_symbols_list);
+int merge_entry_labels(SymbolTable *symbols);
 
 
 
 /**
- * update_code_words - Updates code words in the instructions list with symbol addresses.
+ * update_code_words - Updates code words in the code image with symbol addresses.
  * 
- * This function iterates through the instructions list and updates the code words with
- * the corresponding symbol addresses from the symbols list.  If a symbol is marked as 
+ * This function iterates through the fixups that the first pass recorded (only the words with a label operand)
+ * and updates their code words with the corresponding symbol addresses from the symbol table. If a symbol is marked as 
  * extern, the function adds the appropriate suffix to the code word and adds the symbol 
  * and address to the extern symbols list.
  * 
- * @param head_instructions_list Pointer to the head of the instructions linked list.
- * @param head_symbols_list Pointer to the head of the symbols linked list.
- * @param extern_symbols_list Pointer to the head of the extern symbols linked list.
+ * With bounded memory, only the words that still wait for labels at the end of the first pass (the labels of data lines,
+ * and the labels that were declared external after they were used) are updated: their fixups are sorted by their words,
+ * and every fixup keeps its completed word, which is written when the staged code is copied into the object file.
+ * 
+ * @param ctx The assembly context, holding the fixups and the symbol table. The extern symbol nodes are allocated from its arena.
+ * @param extern_symbols_list The extern symbols list.
  * @return SUCCESS if the analysis is completed successfully, ERROR otherwise.
  */
-int update_code_words(node **head_instructions_list, node **head_symbols_list, node **extern_symbols_list);
+int update_code_words(AssemblyContext *ctx, List *extern_symbols_list);
 
 
 
 /**
  * Adds a new extern symbol node to the extern symbols linked list.
  *
- * This function creates a new node for an extern symbol, initializes it with the provided 
+ * This function creates a new node for an extern symbol from the arena, initializes it with the provided 
  * symbol name and address, and adds it to the end of the extern symbols linked list. 
- * If memory allocation fails, the function prints an error message and exits the program.
  *
+ * @param extern_symbols_list The extern symbols list.
  * @param name The name of the extern symbol to be added.
- * @param adress The address associated with the extern symbol.
- * @param extern_symbols_list A pointer to the head of the extern symbols linked list.
+ * @param address The address associated with the extern symbol.
+ * @param arena The arena to allocate the node from.
  */
-void crate_extern_node(node **head, char *name, int address);
+void crate_extern_node(List *extern_symbols_list, char *name, int address, Arena *arena);
 
 
 
 /**
- * Creates an externals file based on the instructions and symbols lists.
+ * Creates the object file.
  * 
- * This function generates a file with the extension `.ext` containing the external symbols and their addresses
- * based on the instructions and symbols lists. Each line in the file contains the name of an external symbol and the
- * address in the machine code that refers to this symbol. Multiple addresses in the machine code may refer to the 
- * same external symbol. Each such reference has a separate line in the externals file. Addresses are represented in 
- * decimal format.
+ * This function formats the object file in the output buffer of the context and writes it at once.
+ * In the text format (the default) the file has the extension `.ob`: the first line holds the lengths of the instruction
+ * section and of the data section, and then every word of the machine code has a line with its address in decimal
+ * and its value in octal, first the instructions and then the data.
+ * In the binary format the file has the extension `.bin`, and also holds the entry labels and the extern references
+ * (see object_file.h).
+ * With bounded memory, the text file is copied from the staged words a block at a time, and always replaces the existing file.
  * 
  * @param name_file The base name of the source file.
- * @param head_instructions_list Pointer to the head of the instructions list.
- * @param head_symbols_list Pointer to the head of the symbols list.
- */
-void create_object_file(char * name_file, node *head_instructions_list, node *head_data_list);
-
-
-
-/**
- * Converts a 15-character binary string to a 5-digit octal string with leading zeros.
- *
- * @param binary The input binary string (must be 15 characters long).
- * @param octal The output string where the octal representation will be stored.
- *              Ensure the string has enough space to hold 6 characters
- *              (5 digits + null terminator).
+ * @param ctx The assembly context, holding the code image, the data image, the final IC and the format of the file.
+ * @param extern_symbols_list The references to extern labels, (used only by the binary format).
+ * @return SUCCESS if the file was written, ERROR otherwise (the error is reported to the diagnostics of the context).
  */
-void binary_to_octal(const char *binary, char *octal);
+int create_object_file(char * name_file, AssemblyContext *ctx, List *extern_symbols_list);
 
 
 
 /**
- * count_entry_symbols - Counts the number of entry symbols in the symbols list.
- * 
- * This function iterates through the symbols list and counts the number of symbols
- * marked as entry.
- * 
- * @param head_symbols_list Pointer to the head of the symbols linked list.
- * @return The number of extern symbols.
- */
-int count_entry_symbols(node *head_symbols_list);
-
-
-
-/**
- * Creates an entry file based on the symbols list.
+ * Creates an entry file based on the symbol table.
  * 
  * This function generates a file with the extension `.ent` containing the entry symbols and their addresses
- * based on the symbols list. Each line in the file contains the name of a symbol defined as `entry` and its value
- * as found in the symbol table. Values are represented in decimal format.
+ * based on the symbol table. Each line in the file contains the name of a symbol defined as `entry` and its value
+ * as found in the symbol table, in the order the symbols were defined. Values are represented in decimal format.
+ * The file is formatted in the buffer, and is created only if there are entry symbols.
  * 
  * @param name_file The base name of the source file.
- * @param head_symbols_list Pointer to the head of the symbols list.
+ * @param symbols The symbol table.
+ * @param data_base The address the data section starts at, (the final IC), added to the addresses of the data labels.
+ * @param out The buffer that the file is formatted in.
+ * @param diagnostics The buffer that an error in writing the file is reported to.
+ * @return SUCCESS if the file was written or was not needed, ERROR otherwise.
  */
-void create_entry_files(char *name_file, node *head_symbols_list);
+int create_entry_files(char *name_file, SymbolTable *symbols, int data_base, TextBuffer *out, Diagnostics *diagnostics);
 
 
 
@@ -151,23 +132,32 @@ void create_entry_files(char *name_file, node *head_symbols_list);
  * 
  * This function generates the .ext file containing the name of each extern symbol
  * and the corresponding address where it is used in the machine code.
+ * Multiple addresses in the machine code may refer to the same external symbol, each such reference has a separate line.
  * 
  * @param name_file The base name of the source file (without extension).
- * @param extern_symbols_list Pointer to the head of the extern symbols linked list.
+ * @param extern_symbols_list The extern symbols list.
+ * @param out The buffer that the file is formatted in.
+ * @param diagnostics The buffer that an error in writing the file is reported to.
+ * @return SUCCESS if the file was written, ERROR otherwise.
  */
-void create_extern_files(char *name_file, node *head_extern_symbols);
+int create_extern_files(char *name_file, List *extern_symbols_list, TextBuffer *out, Diagnostics *diagnostics);
 
 
 
 /**
- * Deletes memory allocated for a ExternSymbolNode structure.
+ * Creates the external file with bounded memory.
  * 
- * This function frees the ExternSymbolNode structure itself,
- * Because no field of ExternSymbolNode was dynamically allocated
+ * The references to labels that were already external when their words were encoded are read from the staging file
+ * of the context, and are merged with the references that were completed in the second pass, by their addresses.
+ * The lines are the same as those of create_extern_files.
  * 
- * @param e A pointer to the SymbolNode structure to be deleted.
+ * @param name_file The base name of the source file (without extension).
+ * @param ctx The assembly context, holding the staged references and the symbol table.
+ * @param extern_symbols_list The references that were completed in the second pass, in the order of their addresses.
+ * @return SUCCESS if the file was written, ERROR otherwise (the error is reported to the diagnostics of the context).
  */
-void delete_extern_symbol_node(void *e);
+int create_staged_extern_file(char *name_file, AssemblyContext *ctx, List *extern_symbols_list);
+
 
 
  
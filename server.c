@@ -0,0 +1,388 @@
+#define _POSIX_C_SOURCE 200112L /* For the sockets, the signals and the POSIX threads */
+
+#include "server.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include "output.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+
+#define SERVER_BACKLOG 64 /* The connections that may wait to be accepted */
+#define READ_BLOCK_SIZE 4096
+#define INITIAL_CWD_SIZE 256
+
+
+typedef struct {
+	pthread_t thread;
+	int listen_fd;
+} ServerWorker;
+
+
+/* The socket of the server, removed by the handler of the signals that stop it */
+static const char *served_socket_path;
+
+
+
+static void stop_server(int signal_number)
+{
+	(void)signal_number;
+
+	unlink(served_socket_path);
+	_exit(0);
+}
+
+
+
+/* Fills the address of a socket, returns ERROR if the path is too long for it */
+static int socket_address(const char *socket_path, struct sockaddr_un *address)
+{
+	if (strlen(socket_path) >= sizeof(address->sun_path))
+	{
+		printf("Error! The socket path %s is too long\n", socket_path);
+		return ERROR;
+	}
+
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	strcpy(address->sun_path, socket_path);
+
+	return SUCCESS;
+}
+
+
+
+/* Reads a whole request, until the client shuts down its side of the connection.
+   Returns ERROR if it could not be read, timed out or is larger than MAX_REQUEST_SIZE */
+static int read_request(int fd, TextBuffer *request)
+{
+	ssize_t len;
+
+	request->length = 0;
+
+	do
+	{
+		text_buffer_reserve(request, READ_BLOCK_SIZE);
+		len = read(fd, request->text + request->length, READ_BLOCK_SIZE);
+		if (len > 0)
+			request->length += (int)len;
+	}
+	while ((len > 0 || (len == -1 && errno == EINTR)) && request->length <= MAX_REQUEST_SIZE);
+
+	return len == 0 ? SUCCESS : ERROR;
+}
+
+
+
+/* Assembles the files of a request, and prints the reply to the stream of the connection.
+   Returns the number of files that had errors, or 1 if the request itself was not valid */
+static int assemble_request(TextBuffer *request, AssemblyContext *ctx, FILE *out)
+{
+	AssemblerOptions options;
+	char **args;
+	const char *cwd;
+	char *cache_dir = NULL;
+	int i, num_args = 0, num_files, num_failed = 1;
+
+	/* Every string of the request ends with a null terminator, the first one is the working directory of the client */
+	for (i = 0; i < request->length; i++)
+		if (request->text[i] == EOS)
+			num_args++;
+
+	if (num_args == 0 || request->text[request->length - 1] != EOS || request->text[0] != '/')
+	{
+		fprintf(out, "Error! The request is not valid\n");
+		return 1;
+	}
+
+	args = (char **)memory_alloc(num_args * sizeof(char *), MEMORY_DRIVER);
+	for (i = 0, num_args = 0; i < request->length; i += (int)strlen(request->text + i) + 1)
+		args[num_args++] = request->text + i;
+	cwd = args[0];
+
+	num_files = parse_options(num_args - 1, args + 1, &options, out);
+
+	if (num_files != ERROR && options.server_path != NULL)
+		fprintf(out, "Error! The option --server cannot be sent to a server\n");
+
+	else if (num_files != ERROR && count_stream_sources(args + 1, num_files) > 0)
+		fprintf(out, "Error! A source from the standard input (%s) cannot be sent to a server\n", STREAM_NAME);
+
+	else if (num_files != ERROR)
+	{
+		/* The names are taken relative to the working directory of the client, (the names are moved to the start of args + 1) */
+		for (i = 1; i <= num_files; i++)
+			args[i] = generate_full_name(args[i][0] == '/' ? "" : cwd, args[i]);
+
+		if (options.cache_dir != NULL)
+		{
+			cache_dir = generate_full_name(options.cache_dir[0] == '/' ? "" : cwd, options.cache_dir);
+			options.cache_dir = cache_dir;
+		}
+
+		num_failed = assemble_files_with_context(args + 1, num_files, &options, ctx, out);
+
+		for (i = 1; i <= num_files; i++)
+			memory_free(args[i]);
+		memory_free(cache_dir);
+	}
+
+	memory_free(args);
+
+	return num_failed;
+}
+
+
+
+/* Serves one connection, and closes it. A client that does not finish its request within REQUEST_TIMEOUT
+   seconds is dropped, so that it does not hold the worker */
+static void serve_connection(int fd, AssemblyContext *ctx, TextBuffer *request)
+{
+	struct timeval timeout;
+	FILE *out;
+	char status;
+
+	timeout.tv_sec = REQUEST_TIMEOUT;
+	timeout.tv_usec = 0;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0
+		|| read_request(fd, request) == ERROR || (out = fdopen(fd, "w")) == NULL)
+	{
+		close(fd);
+		return;
+	}
+
+	/* The text of the reply is followed by its status */
+	status = assemble_request(request, ctx, out) > 0 ? REPLY_FAILED : REPLY_SUCCEEDED;
+	fputc(EOS, out);
+	fputc(status, out);
+	fclose(out);
+}
+
+
+
+static void *server_worker_main(void *arg)
+{
+	ServerWorker *worker = (ServerWorker *)arg;
+	AssemblyContext ctx;
+	TextBuffer request;
+	MemoryAccount account;
+	int fd;
+
+	/* The allocations are always counted, since any request may ask for the statistics */
+	memory_account_init(&account);
+	memory_use_account(&account);
+	context_init(&ctx);
+	text_buffer_init(&request);
+
+	/* All the workers wait on the same socket, and every connection is accepted by one of them */
+	for (;;)
+	{
+		fd = accept(worker->listen_fd, NULL, NULL);
+		if (fd != -1)
+			serve_connection(fd, &ctx, &request);
+		else if (errno != EINTR && errno != ECONNABORTED)
+			break;
+	}
+
+	printf("Error! The assembler server stopped accepting connections\n");
+
+	text_buffer_free(&request);
+	context_free(&ctx);
+	memory_use_account(NULL);
+
+	return NULL;
+}
+
+
+
+/* Binds the socket to its path. A socket that is left from a server that stopped is removed first,
+   but a socket of a running server is not taken over */
+static int bind_socket(int listen_fd, const char *socket_path, const struct sockaddr_un *address)
+{
+	int probe_fd, in_use;
+
+	if (bind(listen_fd, (const struct sockaddr *)address, sizeof(*address)) == 0)
+		return SUCCESS;
+
+	if (errno != EADDRINUSE)
+	{
+		printf("Error! The socket %s cannot be created\n", socket_path);
+		return ERROR;
+	}
+
+	probe_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	in_use = probe_fd != -1 && connect(probe_fd, (const struct sockaddr *)address, sizeof(*address)) == 0;
+	if (probe_fd != -1)
+		close(probe_fd);
+
+	if (in_use)
+	{
+		printf("Error! An assembler server is already running on %s\n", socket_path);
+		return ERROR;
+	}
+
+	unlink(socket_path);
+	if (bind(listen_fd, (const struct sockaddr *)address, sizeof(*address)) != 0)
+	{
+		printf("Error! The socket %s cannot be created\n", socket_path);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+
+int run_server(const char *socket_path, const AssemblerOptions *options)
+{
+	struct sockaddr_un address;
+	struct sigaction action;
+	ServerWorker *workers;
+	int i, listen_fd, num_started = 0;
+
+	if (socket_address(socket_path, &address) == ERROR)
+		return ERROR;
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd == -1 || bind_socket(listen_fd, socket_path, &address) == ERROR || listen(listen_fd, SERVER_BACKLOG) != 0)
+	{
+		if (listen_fd == -1)
+			printf("Error! The socket %s cannot be created\n", socket_path);
+		else
+			close(listen_fd);
+		return ERROR;
+	}
+
+	/* A client that leaves before its reply is written must not stop the server */
+	memset(&action, 0, sizeof(action));
+	sigemptyset(&action.sa_mask);
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+
+	served_socket_path = socket_path;
+	action.sa_handler = stop_server;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	printf("The assembler server is listening on %s\n", socket_path);
+	fflush(stdout);
+
+	/* The calling thread is the first worker */
+	workers = (ServerWorker *)memory_alloc(options->num_threads * sizeof(ServerWorker), MEMORY_DRIVER);
+	for (i = 0; i < options->num_threads; i++)
+		workers[i].listen_fd = listen_fd;
+
+	for (i = 1; i < options->num_threads; i++)
+	{
+		if (pthread_create(&workers[i].thread, NULL, server_worker_main, &workers[i]) != 0)
+			break;
+		num_started++;
+	}
+
+	server_worker_main(&workers[0]);
+
+	for (i = 1; i <= num_started; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	close(listen_fd);
+	unlink(socket_path);
+	memory_free(workers);
+
+	return ERROR;
+}
+
+
+
+int run_client(const char *socket_path, int argc, char *argv[])
+{
+	struct sockaddr_un address;
+	struct sigaction action;
+	char buffer[READ_BLOCK_SIZE];
+	char *cwd = NULL, *found_cwd, *end;
+	size_t cwd_size = INITIAL_CWD_SIZE;
+	ssize_t len;
+	int i, fd, result = SUCCESS, end_seen = 0, status = EOF;
+
+	if (socket_address(socket_path, &address) == ERROR)
+		return ERROR;
+
+	/* The working directory has no bound on its length, the buffer grows until it fits */
+	do
+	{
+		cwd_size *= 2;
+		cwd = (char *)memory_realloc(cwd, cwd_size, MEMORY_FILE_NAMES);
+	}
+	while ((found_cwd = getcwd(cwd, cwd_size - 1)) == NULL && errno == ERANGE);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (found_cwd == NULL || fd == -1 || connect(fd, (const struct sockaddr *)&address, sizeof(address)) != 0)
+	{
+		printf("Error! The assembler server on %s cannot be reached\n", socket_path);
+		if (fd != -1)
+			close(fd);
+		memory_free(cwd);
+		return ERROR;
+	}
+
+	/* A server that stops while the request is sent is reported as an error, and does not stop the client */
+	memset(&action, 0, sizeof(action));
+	sigemptyset(&action.sa_mask);
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+
+	/* The working directory is sent with a slash at its end, so that a relative name is appended to it as it is */
+	strcat(cwd, "/");
+	if (write_all(fd, cwd, strlen(cwd) + 1) == ERROR)
+		result = ERROR;
+
+	for (i = 0; i < argc && result == SUCCESS; i++)
+		if (write_all(fd, argv[i], strlen(argv[i]) + 1) == ERROR)
+			result = ERROR;
+
+	shutdown(fd, SHUT_WR);
+
+	/* The reply is printed as it arrives, until the null terminator that is followed by its status */
+	while ((len = read(fd, buffer, sizeof(buffer))) > 0 || (len == -1 && errno == EINTR))
+	{
+		if (len <= 0)
+			continue;
+
+		if (!end_seen)
+		{
+			end = (char *)memchr(buffer, EOS, len);
+			fwrite(buffer, 1, end != NULL ? (size_t)(end - buffer) : (size_t)len, stdout);
+
+			/* The status may arrive in the next block */
+			if (end != NULL)
+			{
+				end_seen = 1;
+				if (end + 1 < buffer + len)
+					status = end[1];
+			}
+		}
+		else if (status == EOF)
+			status = buffer[0];
+	}
+
+	if (result == ERROR || len == -1 || status == EOF)
+	{
+		printf("Error! The connection to the assembler server on %s was lost\n", socket_path);
+		result = ERROR;
+	}
+	else if (status != REPLY_SUCCEEDED)
+		result = ERROR;
+
+	close(fd);
+	memory_free(cwd);
+
+	return result;
+}
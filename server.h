@@ -0,0 +1,58 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "driver.h"
+
+
+#define MAX_REQUEST_SIZE (1 << 20) /* The largest request that a server reads, in bytes */
+#define REQUEST_TIMEOUT 10 /* The seconds that a server waits for the next part of a request before it drops the connection */
+#define REPLY_SUCCEEDED '0' /* The status of a reply whose files were all assembled */
+#define REPLY_FAILED '1' /* The status of a reply to a request that was not valid, or that had a file with errors */
+
+
+/*
+ * The assembler server (--server socket) stays resident and assembles the files of requests that arrive on a Unix
+ * domain socket, so that a build that runs the assembler many times does not start a new process for every run.
+ * Every worker of the server keeps its own assembly context from request to request, so its arena, buffers and
+ * tables are already allocated.
+ *
+ * A request is the command line of a client (the options and the names of the source files), preceded by the
+ * working directory of the client, every string with a null terminator:
+ *
+ *     <working directory>/\0<argument>\0<argument>\0...
+ *
+ * The client then shuts down its side of the connection, and the server replies with the text that the assembler
+ * would have printed (the messages and the statistics of the files), followed by a null terminator and the status
+ * of the reply (REPLY_SUCCEEDED or REPLY_FAILED), and closes the connection.
+ * Relative names of source files and of the cache directory are taken relative to the working directory of the client.
+ */
+
+
+
+/**
+ * Runs the assembler as a server on a Unix domain socket, until it is stopped by a signal (SIGINT or SIGTERM),
+ * which removes the socket. Requests are served at the same time by options->num_threads workers (-j),
+ * and the files of one request are assembled one after the other.
+ *
+ * @param socket_path The path of the socket. A socket that is left from a server that is no longer running is replaced.
+ * @param options The command line options of the server.
+ * @return ERROR if the server could not be started (an error message is printed).
+ */
+int run_server(const char *socket_path, const AssemblerOptions *options);
+
+
+
+/**
+ * Sends a command line to a running server, and prints its reply to the standard output.
+ *
+ * @param socket_path The path of the socket of the server.
+ * @param argc The number of arguments.
+ * @param argv The arguments to send (without the name of the program and the option that selects the server).
+ * @return SUCCESS if the files were all assembled, ERROR if a file had errors, the request was not valid
+ *         or the server could not be reached (an error message is printed).
+ */
+int run_client(const char *socket_path, int argc, char *argv[]);
+
+
+
+#endif
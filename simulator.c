@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "utils_and_checks.h"
+#include "first_pass.h"
+#include "object_file.h"
+#include "stats.h"
+#include "memory.h"
+
+
+/*
+ * Runs object files on the 15-bit machine of the assembler:
+ *
+ *     simulator [--steps N] file...
+ *
+ * Every file is an object file (file.ob, or file.bin, see object_file.h), as written by the assembler or by the linker.
+ * Its words are loaded at their addresses, and the program runs from its first instruction word until it reaches
+ * `stop`, or until N instructions were executed (the step limit, DEFAULT_STEPS by default).
+ *
+ * The instructions are decoded from the same layout that encoding_instructions produces, once, into a cache with
+ * an entry for every address: the handler of the operation and the cells of its operands, (registers, memory words,
+ * or the values of immediate numbers). The interpreter is threaded through the handlers: every handler executes its
+ * instruction and returns the address of the next one, whose handler is called right away. The instruction words
+ * are decoded when the file is loaded, and a word that is written by the program is decoded again before it runs.
+ *
+ * The program reads characters with `red` and writes characters with `prn` on the standard input and output.
+ * For every file, a summary with the reason it stopped, the number of instructions, the instructions per second
+ * and the registers is printed to the standard error. The exit status is 1 if any program did not reach `stop`.
+ */
+
+
+#define MACHINE_MEMORY_SIZE (OPERAND_MASK + 1) /* Every address of 12 bits */
+#define DEFAULT_STEPS 100000000L
+#define STACK_SIZE 1024 /* The return addresses of jsr */
+
+/* The cells of the machine: the memory, then the registers, then the values of the immediate numbers
+   (the value of the immediate number in the word at address a is in the cell IMMEDIATE_CELLS + a) */
+#define REGISTER_CELLS MACHINE_MEMORY_SIZE
+#define IMMEDIATE_CELLS (REGISTER_CELLS + NUM_REGISTERS)
+#define NUM_CELLS (IMMEDIATE_CELLS + MACHINE_MEMORY_SIZE)
+
+#define ARE_MASK ((1 << ARE_BITS) - 1)
+#define SIGN_BIT 0x4000 /* The sign bit of a 15-bit word */
+#define MODE_FIELD_MASK 0xF /* The 4 bits of the addressing modes of an operand in the first word */
+
+/* The values that a handler returns instead of the address of the next instruction */
+#define RUN_STOPPED -1 /* The program reached stop */
+#define RUN_FAULT -2 /* The instruction could not be executed, the reason was reported */
+
+#define OPERAND_EXTERNAL 2 /* An operand that refers to an external label, (differs from SUCCESS and ERROR) */
+
+
+typedef struct Simulator Simulator;
+typedef struct Instruction Instruction;
+
+/* Executes an instruction, and returns the address of the next one, (or RUN_STOPPED or RUN_FAULT) */
+typedef int (*Handler)(Simulator *sim, const Instruction *inst);
+
+
+/* An operand of a decoded instruction */
+typedef struct {
+	int cell; /* The cell of the operand, or the cell of the register that points to it */
+	int indirect; /* 1 in indirect register addressing, the cell of the operand is the address in the register */
+} Operand;
+
+
+/* An entry of the instruction cache */
+struct Instruction {
+	Handler handler;
+	Operand source;
+	Operand target;
+	int address;
+	int next; /* The address of the next instruction */
+};
+
+
+struct Simulator {
+	uint16_t cells[NUM_CELLS];
+	Instruction cache[MACHINE_MEMORY_SIZE];
+	int zero_flag; /* The Z flag of the status word, set by cmp */
+	int stack[STACK_SIZE];
+	int stack_depth;
+	Diagnostics diagnostics;
+};
+
+
+
+/* Returns the cell of an operand, (the address of an indirect operand is taken from its register when it is used) */
+static int operand_cell(const Simulator *sim, const Operand *operand)
+{
+	return operand->indirect ? sim->cells[operand->cell] & OPERAND_MASK : operand->cell;
+}
+
+
+
+/* Returns the value of a word as a signed number */
+static int signed_word(unsigned int word)
+{
+	return (word & SIGN_BIT) ? (int)word - (WORD_MASK + 1) : (int)word;
+}
+
+
+
+static int decode_and_run(Simulator *sim, const Instruction *inst);
+
+
+
+/* Writes a cell. A memory word that is written is decoded again before it runs as a part of an instruction,
+   (an instruction takes up to 3 words, so the instructions that start at the 2 words before it are decoded again too) */
+static void store(Simulator *sim, int cell, int value)
+{
+	int address;
+
+	sim->cells[cell] = (uint16_t)(value & WORD_MASK);
+
+	if (cell < MACHINE_MEMORY_SIZE)
+		for (address = cell; address >= 0 && address > cell - 3; address--)
+			sim->cache[address].handler = decode_and_run;
+}
+
+
+
+#define SOURCE_VALUE(sim, inst) ((sim)->cells[operand_cell(sim, &(inst)->source)])
+#define TARGET_VALUE(sim, inst) ((sim)->cells[operand_cell(sim, &(inst)->target)])
+
+
+
+/* The handlers of the operations, in the order of their operation codes */
+
+static int run_mov(Simulator *sim, const Instruction *inst)
+{
+	store(sim, operand_cell(sim, &inst->target), SOURCE_VALUE(sim, inst));
+	return inst->next;
+}
+
+
+
+static int run_cmp(Simulator *sim, const Instruction *inst)
+{
+	sim->zero_flag = ((SOURCE_VALUE(sim, inst) - TARGET_VALUE(sim, inst)) & WORD_MASK) == 0;
+	return inst->next;
+}
+
+
+
+static int run_add(Simulator *sim, const Instruction *inst)
+{
+	int cell = operand_cell(sim, &inst->target);
+
+	store(sim, cell, sim->cells[cell] + SOURCE_VALUE(sim, inst));
+	return inst->next;
+}
+
+
+
+static int run_sub(Simulator *sim, const Instruction *inst)
+{
+	int cell = operand_cell(sim, &inst->target);
+
+	store(sim, cell, sim->cells[cell] - SOURCE_VALUE(sim, inst));
+	return inst->next;
+}
+
+
+
+/* The source of lea is a label, its cell is its address */
+static int run_lea(Simulator *sim, const Instruction *inst)
+{
+	store(sim, operand_cell(sim, &inst->target), inst->source.cell);
+	return inst->next;
+}
+
+
+
+static int run_clr(Simulator *sim, const Instruction *inst)
+{
+	store(sim, operand_cell(sim, &inst->target), 0);
+	return inst->next;
+}
+
+
+
+static int run_not(Simulator *sim, const Instruction *inst)
+{
+	int cell = operand_cell(sim, &inst->target);
+
+	store(sim, cell, ~sim->cells[cell]);
+	return inst->next;
+}
+
+
+
+static int run_inc(Simulator *sim, const Instruction *inst)
+{
+	int cell = operand_cell(sim, &inst->target);
+
+	store(sim, cell, sim->cells[cell] + 1);
+	return inst->next;
+}
+
+
+
+static int run_dec(Simulator *sim, const Instruction *inst)
+{
+	int cell = operand_cell(sim, &inst->target);
+
+	store(sim, cell, sim->cells[cell] - 1);
+	return inst->next;
+}
+
+
+
+/* The target of a jump is an address in memory, (a label, or the address in a register) */
+static int run_jmp(Simulator *sim, const Instruction *inst)
+{
+	return operand_cell(sim, &inst->target);
+}
+
+
+
+static int run_bne(Simulator *sim, const Instruction *inst)
+{
+	return sim->zero_flag ? inst->next : operand_cell(sim, &inst->target);
+}
+
+
+
+/* Reads a character, the end of the input is read as -1 */
+static int run_red(Simulator *sim, const Instruction *inst)
+{
+	store(sim, operand_cell(sim, &inst->target), getchar());
+	return inst->next;
+}
+
+
+
+static int run_prn(Simulator *sim, const Instruction *inst)
+{
+	putchar(TARGET_VALUE(sim, inst) & 0xFF);
+	return inst->next;
+}
+
+
+
+static int run_jsr(Simulator *sim, const Instruction *inst)
+{
+	if (sim->stack_depth == STACK_SIZE)
+	{
+		report(&sim->diagnostics, "Error! The stack overflowed at address %d (more than %d nested calls)\n", inst->address, STACK_SIZE);
+		return RUN_FAULT;
+	}
+
+	sim->stack[sim->stack_depth++] = inst->next;
+	return operand_cell(sim, &inst->target);
+}
+
+
+
+static int run_rts(Simulator *sim, const Instruction *inst)
+{
+	if (sim->stack_depth == 0)
+	{
+		report(&sim->diagnostics, "Error! rts at address %d, with no call to return from\n", inst->address);
+		return RUN_FAULT;
+	}
+
+	return sim->stack[--sim->stack_depth];
+}
+
+
+
+static int run_stop(Simulator *sim, const Instruction *inst)
+{
+	(void)sim;
+	(void)inst;
+
+	return RUN_STOPPED;
+}
+
+
+
+static int run_illegal(Simulator *sim, const Instruction *inst)
+{
+	report(&sim->diagnostics, "Error! The word %05o at address %d is not a valid instruction\n", sim->cells[inst->address], inst->address);
+	return RUN_FAULT;
+}
+
+
+
+static int run_external(Simulator *sim, const Instruction *inst)
+{
+	report(&sim->diagnostics, "Error! The instruction at address %d refers to an external label, (the file must be linked first)\n", inst->address);
+	return RUN_FAULT;
+}
+
+
+
+static const Handler operation_handlers[NUM_OP_NAMES] = {
+	run_mov, run_cmp, run_add, run_sub, run_lea, run_clr, run_not, run_inc,
+	run_dec, run_jmp, run_bne, run_red, run_prn, run_jsr, run_rts, run_stop
+};
+
+
+
+/* Returns the addressing mode of a field of the first word, or ERROR if the field does not hold exactly one mode of the legal ones */
+static int field_mode(int field, int legal_modes)
+{
+	int mode;
+
+	for (mode = 0; mode < NUM_ADDRESSING_MODES; mode++)
+		if (field == (1 << mode))
+			return ((legal_modes >> mode) & 1) ? mode : ERROR;
+
+	return ERROR;
+}
+
+
+
+/* Decodes an operand from its additional word. Returns ERROR if the word is not valid for the mode,
+   or OPERAND_EXTERNAL if it refers to an external label */
+static int decode_operand(Simulator *sim, Operand *operand, int mode, int address, int is_target)
+{
+	unsigned int word = sim->cells[address];
+
+	operand->indirect = mode == MODE_INDIRECT_REGISTER;
+
+	switch (mode)
+	{
+		case MODE_IMMEDIATE:
+			/* The 12-bit number is extended to a 15-bit word */
+			operand->cell = IMMEDIATE_CELLS + address;
+			sim->cells[operand->cell] = (uint16_t)((((word >> ARE_BITS) ^ 0x800) - 0x800) & WORD_MASK);
+			return (word & ARE_MASK) == ARE_ABSOLUTE ? SUCCESS : ERROR;
+
+		case MODE_DIRECT:
+			operand->cell = word >> ARE_BITS;
+			if ((word & ARE_MASK) == ARE_EXTERNAL)
+				return OPERAND_EXTERNAL;
+			return (word & ARE_MASK) == ARE_RELOCATABLE ? SUCCESS : ERROR;
+
+		default:
+			operand->cell = REGISTER_CELLS + ((word >> (is_target ? TARGET_REG_SHIFT : SOURCE_REG_SHIFT)) & (NUM_REGISTERS - 1));
+			return (word & ARE_MASK) == ARE_ABSOLUTE ? SUCCESS : ERROR;
+	}
+}
+
+
+
+/* Decodes the instruction that starts at an address into the cache */
+static void decode(Simulator *sim, int address)
+{
+	Instruction *inst = &sim->cache[address];
+	const Operation *operation;
+	unsigned int word = sim->cells[address];
+	int source_mode = ERROR, target_mode = ERROR, next = address + 1, source_result = SUCCESS, target_result = SUCCESS;
+
+	inst->address = address;
+	inst->handler = run_illegal;
+
+	/* The operation code is checked before it indexes the table, a word of a .bin file may have more than 15 bits */
+	if (word > WORD_MASK || (word >> OPCODE_SHIFT) >= NUM_OP_NAMES || (word & ARE_MASK) != ARE_ABSOLUTE)
+		return;
+
+	operation = &op_names_table[word >> OPCODE_SHIFT];
+
+	/* The fields of the operands that the operation does not have must be zero */
+	if (operation->num_operands == 2)
+		source_mode = field_mode((word >> SOURCE_MODE_SHIFT) & MODE_FIELD_MASK, operation->source_modes);
+	else if (((word >> SOURCE_MODE_SHIFT) & MODE_FIELD_MASK) != 0)
+		return;
+
+	if (operation->num_operands >= 1)
+		target_mode = field_mode((word >> TARGET_MODE_SHIFT) & MODE_FIELD_MASK, operation->target_modes);
+	else if (((word >> TARGET_MODE_SHIFT) & MODE_FIELD_MASK) != 0)
+		return;
+
+	if ((operation->num_operands == 2 && source_mode == ERROR) || (operation->num_operands >= 1 && target_mode == ERROR))
+		return;
+
+	/* The additional words, two register operands share one word */
+	if (operation->num_operands == 2)
+	{
+		if (next >= MACHINE_MEMORY_SIZE || (source_result = decode_operand(sim, &inst->source, source_mode, next, 0)) == ERROR)
+			return;
+		if (!((MODES_REGISTERS >> source_mode) & (MODES_REGISTERS >> target_mode) & 1))
+			next++;
+	}
+
+	if (operation->num_operands >= 1)
+	{
+		/* As encoding_instructions does, the register of a single operand is in the place of a source register */
+		if (next >= MACHINE_MEMORY_SIZE || (target_result = decode_operand(sim, &inst->target, target_mode, next, operation->num_operands == 2)) == ERROR)
+			return;
+		next++;
+	}
+
+	/* The address wraps around at the end of the memory, as the 12 bits of an address do */
+	inst->next = next & OPERAND_MASK;
+	if (source_result == OPERAND_EXTERNAL || target_result == OPERAND_EXTERNAL)
+		inst->handler = run_external;
+	else
+		inst->handler = operation_handlers[word >> OPCODE_SHIFT];
+}
+
+
+
+/* The handler of an instruction that is not decoded yet, (or whose words were written) */
+static int decode_and_run(Simulator *sim, const Instruction *inst)
+{
+	Instruction *decoded = &sim->cache[inst->address];
+
+	decode(sim, decoded->address);
+	return decoded->handler(sim, decoded);
+}
+
+
+
+/* Loads the words of an image into the memory of a new machine, and decodes its instructions.
+   Returns the address of the first instruction, or ERROR if the image does not fit in the memory */
+static int load_image(Simulator *sim, const ObjectImage *image, const char *file_name)
+{
+	int i, end = image->base_address + image->code_count + image->data_count;
+
+	if (image->base_address < 0 || end > MACHINE_MEMORY_SIZE)
+	{
+		report(&sim->diagnostics, "Error! The image of %s (addresses %d to %d) does not fit in the memory of %d words\n", file_name, image->base_address, end - 1, MACHINE_MEMORY_SIZE);
+		return ERROR;
+	}
+
+	memset(sim->cells, 0, sizeof(sim->cells));
+	memcpy(sim->cells + image->base_address, image->code, image->code_count * sizeof(uint16_t));
+	memcpy(sim->cells + image->base_address + image->code_count, image->data, image->data_count * sizeof(uint16_t));
+	sim->zero_flag = 0;
+	sim->stack_depth = 0;
+
+	for (i = 0; i < MACHINE_MEMORY_SIZE; i++)
+	{
+		sim->cache[i].address = i;
+		sim->cache[i].handler = decode_and_run;
+	}
+
+	/* Every word of the instruction section may start an instruction */
+	for (i = image->base_address; i < image->base_address + image->code_count; i++)
+		decode(sim, i);
+
+	return image->base_address;
+}
+
+
+
+/* Runs the program from an address, until it stops, faults, or runs max_steps instructions.
+   Returns RUN_STOPPED, RUN_FAULT, or the address of the next instruction if the step limit was reached */
+static int run(Simulator *sim, int address, long max_steps, long *steps, int *last_address)
+{
+	const Instruction *inst;
+	long count = 0;
+
+	while (count < max_steps && address >= 0)
+	{
+		inst = &sim->cache[address];
+		*last_address = address;
+		address = inst->handler(sim, inst);
+		count++;
+	}
+
+	*steps = count;
+	return address;
+}
+
+
+
+/* Reads a positive number of steps, returns ERROR if it is not valid */
+static long parse_steps(const char *str)
+{
+	char *end;
+	long num = strtol(str, &end, 10);
+
+	return (*str == EOS || *end != EOS || num < 1) ? ERROR : num;
+}
+
+
+
+/* Loads and runs one file, prints its summary to the standard error. Returns SUCCESS if the program reached stop */
+static int simulate_file(Simulator *sim, const char *file_name, long max_steps, double *total_time, long *total_steps)
+{
+	ObjectImage image;
+	int i, address, last_address = 0, result;
+	long steps = 0;
+	double start, elapsed;
+
+	object_image_init(&image);
+	diagnostics_init(&sim->diagnostics);
+
+	address = ERROR;
+	if (object_load(&image, file_name, &sim->diagnostics) == SUCCESS)
+		address = load_image(sim, &image, file_name);
+	object_image_free(&image);
+
+	if (address == ERROR)
+	{
+		fflush(stdout);
+		diagnostics_flush(&sim->diagnostics, stderr);
+		diagnostics_free(&sim->diagnostics);
+		return ERROR;
+	}
+
+	start = stats_clock();
+	result = run(sim, address, max_steps, &steps, &last_address);
+	elapsed = stats_clock() - start;
+	*total_time += elapsed;
+	*total_steps += steps;
+
+	/* The output of the program comes before its summary */
+	fflush(stdout);
+	diagnostics_flush(&sim->diagnostics, stderr);
+
+	if (result == RUN_STOPPED)
+		fprintf(stderr, "%s: stopped at address %d", file_name, last_address);
+	else if (result == RUN_FAULT)
+		fprintf(stderr, "%s: faulted at address %d", file_name, last_address);
+	else
+		fprintf(stderr, "%s: reached the step limit at address %d", file_name, result);
+
+	fprintf(stderr, " after %ld instructions (%.0f instructions per second)\n\tregisters", steps, elapsed > 0 ? steps / elapsed : 0.0);
+	for (i = 0; i < NUM_REGISTERS; i++)
+		fprintf(stderr, " r%d=%d", i, signed_word(sim->cells[REGISTER_CELLS + i]));
+	fprintf(stderr, ", Z=%d\n", sim->zero_flag);
+
+	diagnostics_free(&sim->diagnostics);
+
+	return result == RUN_STOPPED ? SUCCESS : ERROR;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	Simulator *sim;
+	long max_steps = DEFAULT_STEPS, total_steps = 0;
+	double total_time = 0;
+	int i, num_files = 0, num_failed = 0;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--steps") == 0)
+		{
+			if (i + 1 == argc || (max_steps = parse_steps(argv[++i])) == ERROR)
+			{
+				printf("Error! The option --steps expects a positive number of instructions\n");
+				return 1;
+			}
+		}
+		else
+			argv[++num_files] = argv[i];
+	}
+
+	if (num_files == 0)
+	{
+		printf("Usage: simulator [--steps N] file...\n");
+		return 1;
+	}
+
+	/* The machine is large (its memory, registers and instruction cache), and is used again for every file */
+	sim = (Simulator *)memory_alloc(sizeof(Simulator), MEMORY_CODE);
+
+	for (i = 1; i <= num_files; i++)
+		if (simulate_file(sim, argv[i], max_steps, &total_time, &total_steps) == ERROR)
+			num_failed++;
+
+	if (num_files > 1)
+		fprintf(stderr, "All the %d files: %d did not stop, %ld instructions (%.0f instructions per second)\n", num_files, num_failed, total_steps, total_time > 0 ? total_steps / total_time : 0.0);
+
+	memory_free(sim);
+
+	return num_failed > 0;
+}
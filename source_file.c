@@ -0,0 +1,178 @@
+#define _POSIX_C_SOURCE 200112L /* For mmap */
+
+#include "source_file.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define READ_BLOCK_SIZE 65536 /* The size of the blocks that files which cannot be mapped are read in */
+
+
+
+/* Adds an entry to the line index, growing it if needed */
+static void add_line_start(SourceFile *source, size_t offset)
+{
+	
+	if (source->num_lines == source->capacity)
+	{
+		source->capacity = source->capacity ? 2 * source->capacity : SOURCE_INIT_LINES;
+		source->line_starts = (size_t *)memory_realloc(source->line_starts, source->capacity * sizeof(size_t), MEMORY_SOURCE);
+	}
+	
+	source->line_starts[source->num_lines++] = offset;
+}
+
+
+
+/* Finds the start of every line, jumping from one newline to the next with memchr */
+static void index_lines(SourceFile *source)
+{
+	const char *start = source->data, *end = source->data + source->size, *newline;
+	
+	source->num_lines = 0;
+	
+	while (start < end)
+	{
+		add_line_start(source, start - source->data);
+		
+		newline = (const char *)memchr(start, '\n', end - start);
+		start = newline ? newline + 1 : end;
+	}
+	
+	/* The closing entry, so that every line ends where the next one starts */
+	add_line_start(source, source->size);
+	source->num_lines--;
+}
+
+
+
+/* Reads a file that cannot be mapped (such as a pipe) into an allocated buffer */
+static int read_whole_file(SourceFile *source, int fd)
+{
+	size_t capacity = READ_BLOCK_SIZE;
+	ssize_t len;
+	
+	source->data = (char *)memory_alloc(capacity, MEMORY_SOURCE);
+	
+	while ((len = read(fd, source->data + source->size, capacity - source->size)) > 0)
+	{
+		source->size += len;
+		if (source->size == capacity)
+		{
+			capacity *= 2;
+			source->data = (char *)memory_realloc(source->data, capacity, MEMORY_SOURCE);
+		}
+	}
+	
+	return len < 0 ? ERROR : SUCCESS;
+}
+
+
+
+void source_init(SourceFile *source)
+{
+	source->data = NULL;
+	source->size = 0;
+	source->is_mapped = 0;
+	source->line_starts = NULL;
+	source->num_lines = 0;
+	source->capacity = 0;
+}
+
+
+
+/* Maps or reads an open file, and indexes its lines. The file descriptor is not closed */
+static int load_file(SourceFile *source, int fd)
+{
+	struct stat info;
+	int result = SUCCESS;
+	void *map;
+	
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		/* A private mapping of the whole file, its pages are read in by the system as they are used */
+		map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			source->data = (char *)map;
+			source->size = info.st_size;
+			source->is_mapped = 1;
+		}
+	}
+	
+	if (!source->is_mapped)
+		result = read_whole_file(source, fd);
+	
+	if (result == ERROR)
+	{
+		source_close(source);
+		return ERROR;
+	}
+	
+	index_lines(source);
+	
+	return SUCCESS;
+}
+
+
+
+int source_open(SourceFile *source, const char *path)
+{
+	int fd, result;
+	
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return ERROR;
+	
+	result = load_file(source, fd);
+	close(fd);
+	
+	return result;
+}
+
+
+
+int source_read_stdin(SourceFile *source)
+{
+	return load_file(source, STDIN_FILENO);
+}
+
+
+
+const char *source_line(SourceFile *source, int line_index, int *len)
+{
+	*len = (int)(source->line_starts[line_index + 1] - source->line_starts[line_index]);
+	
+	return source->data + source->line_starts[line_index];
+}
+
+
+
+void source_close(SourceFile *source)
+{
+	if (source->is_mapped)
+		munmap(source->data, source->size);
+	else
+		memory_free(source->data);
+	
+	source->data = NULL;
+	source->size = 0;
+	source->is_mapped = 0;
+	source->num_lines = 0;
+}
+
+
+
+void source_free(SourceFile *source)
+{
+	source_close(source);
+	memory_free(source->line_starts);
+	source_init(source);
+}
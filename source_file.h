@@ -0,0 +1,88 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <stddef.h>
+
+
+#define SOURCE_INIT_LINES 1024 /* Initial size of the line index */
+
+
+/*
+ * A source file in memory. Regular files are mapped into memory instead of being read, other files
+ * (such as pipes) are read into an allocated buffer. In both cases the bytes are used in place.
+ * The line index holds the offset of the start of every line, and one more entry with the size
+ * of the file, so that line n spans from line_starts[n] to line_starts[n + 1] (including its '\n').
+ */
+typedef struct {
+	char *data;
+	size_t size;
+	int is_mapped; /* 1 if data is a memory mapping of the file, 0 if it was allocated */
+	size_t *line_starts;
+	int num_lines;
+	int capacity; /* The number of entries allocated for the line index */
+} SourceFile;
+
+
+
+/**
+ * Initializes an empty source file.
+ *
+ * @param source The source file to initialize.
+ */
+void source_init(SourceFile *source);
+
+
+
+/**
+ * Opens a file, maps it into memory (or reads it, if it cannot be mapped), and indexes its lines.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param source The source file, must be empty (new or closed).
+ * @param path The path of the file.
+ * @return SUCCESS if the file was opened, ERROR if it cannot be opened or read.
+ */
+int source_open(SourceFile *source, const char *path);
+
+
+
+/**
+ * Reads the standard input as a source file, (mapped if it is redirected from a regular file, read to its end otherwise).
+ *
+ * @param source The source file, must be empty (new or closed).
+ * @return SUCCESS if the input was read, ERROR otherwise.
+ */
+int source_read_stdin(SourceFile *source);
+
+
+
+/**
+ * Returns the start of a line and its length. The line is not null-terminated.
+ *
+ * @param source The source file.
+ * @param line_index The index of the line, from 0 to num_lines - 1.
+ * @param len A pointer to the length of the line, including its '\n' character (if it has one).
+ * @return A pointer to the first character of the line.
+ */
+const char *source_line(SourceFile *source, int line_index, int *len);
+
+
+
+/**
+ * Unmaps or frees the bytes of the file. The memory of the line index is kept for the next file.
+ *
+ * @param source The source file to close.
+ */
+void source_close(SourceFile *source);
+
+
+
+/**
+ * Closes the source file and frees the line index.
+ *
+ * @param source The source file to free.
+ */
+void source_free(SourceFile *source);
+
+
+
+#endif
@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200112L /* For open, lseek and write */
+
+#include "staging.h"
+#include "output.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+
+void staging_init(StagingFile *file)
+{
+	file->fd = -1;
+	file->name = NULL;
+	text_buffer_init(&file->buffer);
+	file->flushed = 0;
+	file->failed = 0;
+}
+
+
+
+int staging_open(StagingFile *file, const char *name_file, const char *extension, Diagnostics *diagnostics)
+{
+	file->name = generate_full_name(name_file, extension);
+	file->fd = open(file->name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	file->buffer.length = 0;
+	file->flushed = 0;
+	file->failed = 0;
+
+	if (file->fd == -1)
+	{
+		report(diagnostics, "Error! The file %s cannot be opened for writing\n", file->name);
+		memory_free(file->name);
+		file->name = NULL;
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+
+/* Writes the buffer to the end of the file */
+static void flush_buffer(StagingFile *file)
+{
+	if (file->buffer.length == 0)
+		return;
+
+	if (lseek(file->fd, file->flushed, SEEK_SET) == -1 || write_all(file->fd, file->buffer.text, file->buffer.length) == ERROR)
+		file->failed = 1;
+
+	file->flushed += file->buffer.length;
+	file->buffer.length = 0;
+}
+
+
+
+void staging_spill(StagingFile *file)
+{
+	if (file->buffer.length >= STAGING_FLUSH_SIZE)
+		flush_buffer(file);
+}
+
+
+
+void staging_append(StagingFile *file, const char *data, int len)
+{
+	text_buffer_append(&file->buffer, data, len);
+	staging_spill(file);
+}
+
+
+
+long staging_length(const StagingFile *file)
+{
+	return file->flushed + file->buffer.length;
+}
+
+
+
+void staging_overwrite(StagingFile *file, long offset, const char *data, int len)
+{
+	int in_file = 0;
+
+	/* The part before the buffer was already written to the file */
+	if (offset < file->flushed)
+	{
+		in_file = offset + len <= file->flushed ? len : (int)(file->flushed - offset);
+		if (lseek(file->fd, offset, SEEK_SET) == -1 || write_all(file->fd, data, in_file) == ERROR)
+			file->failed = 1;
+	}
+
+	if (in_file < len)
+		memcpy(file->buffer.text + (offset + in_file - file->flushed), data + in_file, len - in_file);
+}
+
+
+
+int staging_rewind(StagingFile *file, Diagnostics *diagnostics)
+{
+	flush_buffer(file);
+
+	if (file->failed || lseek(file->fd, 0, SEEK_SET) == -1)
+	{
+		report(diagnostics, "Error! The file %s cannot be written\n", file->name);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+
+int staging_read(StagingFile *file, char *dest, int len)
+{
+	int total = 0, count;
+
+	/* A read may return less than asked for before the end of the file */
+	while (total < len)
+	{
+		count = (int)read(file->fd, dest + total, len - total);
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			break;
+		total += count;
+	}
+
+	return total;
+}
+
+
+
+int staging_keep(StagingFile *file, const char *name_file, const char *extension, Diagnostics *diagnostics)
+{
+	char *full_name_file = generate_full_name(name_file, extension);
+	int result = SUCCESS;
+
+	flush_buffer(file);
+
+	if (close(file->fd) != 0 || file->failed || rename(file->name, full_name_file) != 0)
+	{
+		report(diagnostics, "Error! The file %s cannot be written\n", full_name_file);
+		unlink(file->name);
+		result = ERROR;
+	}
+
+	file->fd = -1;
+	memory_free(full_name_file);
+	staging_close(file);
+
+	return result;
+}
+
+
+
+void staging_close(StagingFile *file)
+{
+	if (file->fd != -1)
+	{
+		close(file->fd);
+		unlink(file->name);
+	}
+
+	memory_free(file->name);
+	text_buffer_free(&file->buffer);
+	staging_init(file);
+}
@@ -0,0 +1,139 @@
+#ifndef STAGING_H
+#define STAGING_H
+
+#include "text_buffer.h"
+#include "diagnostics.h"
+
+
+#define STAGING_FLUSH_SIZE 65536 /* The appended content of a staging file is written out once it is this long */
+#define STAGING_BLOCK_SIZE 8192 /* The size of the blocks that a staging file is read back in */
+
+
+/*
+ * A temporary file that a part of an output file is staged in, while the rest of the output is not known yet
+ * (the assembly with bounded memory, see --bounded-memory in driver.h). The content is appended to the buffer
+ * of the file, which is written to the file whenever it grows past STAGING_FLUSH_SIZE, so that only that much
+ * is held in memory. Content that was already appended can still be overwritten in place, until it is read back.
+ */
+typedef struct {
+	int fd; /* -1 if the file is not open */
+	char *name; /* The name of the file, or NULL if it is not open */
+	TextBuffer buffer; /* The appended content that was not written to the file yet */
+	long flushed; /* The length of the content that was already written to the file */
+	int failed; /* 1 once a write to the file failed, it is reported when the file is read back or kept */
+} StagingFile;
+
+
+
+/**
+ * Initializes a staging file that is not open.
+ *
+ * @param file The staging file to initialize.
+ */
+void staging_init(StagingFile *file);
+
+
+
+/**
+ * Creates the file of a staging file, empty, named by a base name and an extension.
+ *
+ * @param file A staging file that is not open.
+ * @param name_file The base name of the file.
+ * @param extension The extension of the file.
+ * @param diagnostics The buffer that an error message is reported to.
+ * @return SUCCESS if the file was created, ERROR otherwise (the error is reported).
+ */
+int staging_open(StagingFile *file, const char *name_file, const char *extension, Diagnostics *diagnostics);
+
+
+
+/**
+ * Writes the buffer of a staging file to the file if it grew past STAGING_FLUSH_SIZE.
+ * It is called after content is appended to the buffer directly.
+ *
+ * @param file The staging file.
+ */
+void staging_spill(StagingFile *file);
+
+
+
+/**
+ * Appends content to a staging file.
+ *
+ * @param file The staging file.
+ * @param data The content.
+ * @param len The length of the content.
+ */
+void staging_append(StagingFile *file, const char *data, int len);
+
+
+
+/**
+ * Returns the length of the content of a staging file, in the file and in its buffer.
+ *
+ * @param file The staging file.
+ * @return The length of the content.
+ */
+long staging_length(const StagingFile *file);
+
+
+
+/**
+ * Overwrites content that was already appended to a staging file, wherever it is (in the file or in the buffer).
+ *
+ * @param file The staging file.
+ * @param offset The position of the content to overwrite.
+ * @param data The new content.
+ * @param len The length of the content, offset + len must not be past the end of the content.
+ */
+void staging_overwrite(StagingFile *file, long offset, const char *data, int len);
+
+
+
+/**
+ * Writes the buffer of a staging file to the file, and moves back to its start so that it can be read.
+ *
+ * @param file The staging file.
+ * @param diagnostics The buffer that an error message is reported to.
+ * @return SUCCESS if the whole content is in the file, ERROR if a write to it failed (the error is reported).
+ */
+int staging_rewind(StagingFile *file, Diagnostics *diagnostics);
+
+
+
+/**
+ * Reads the next part of a staging file, after staging_rewind.
+ *
+ * @param file The staging file.
+ * @param dest The buffer to read into.
+ * @param len The size of the buffer.
+ * @return The number of characters that were read, 0 at the end of the file.
+ */
+int staging_read(StagingFile *file, char *dest, int len);
+
+
+
+/**
+ * Closes a staging file and turns it into an output file: it is renamed to the base name with another extension,
+ * replacing the file of that name.
+ *
+ * @param file The staging file, it is left closed.
+ * @param name_file The base name of the output file.
+ * @param extension The extension of the output file.
+ * @param diagnostics The buffer that an error message is reported to.
+ * @return SUCCESS if the output file was written, ERROR otherwise (the error is reported, and the staging file is removed).
+ */
+int staging_keep(StagingFile *file, const char *name_file, const char *extension, Diagnostics *diagnostics);
+
+
+
+/**
+ * Closes and removes a staging file, if it is open, and frees its buffer.
+ *
+ * @param file The staging file, it is left closed.
+ */
+void staging_close(StagingFile *file);
+
+
+
+#endif
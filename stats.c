@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200112L /* For clock_gettime */
+
+#include "stats.h"
+#include <stdio.h>
+#include <time.h>
+
+
+static const char *stage_names[NUM_STAGES] = {
+	"macro_analyze", "first_pass_analyze", "merge_entry_labels", "update_code_words", "create_object_file", "create_other_files", "build_cache"
+};
+
+
+
+static void clear_counters(MemoryCounters *counters)
+{
+	counters->allocations = 0;
+	counters->live_bytes = 0;
+	counters->peak_bytes = 0;
+}
+
+
+
+/* Adds the allocations of a file to the totals, the peak of the totals is the largest peak of a file */
+static void add_counters(MemoryCounters *total, const MemoryCounters *counters)
+{
+	total->allocations += counters->allocations;
+	if (counters->peak_bytes > total->peak_bytes)
+		total->peak_bytes = counters->peak_bytes;
+}
+
+
+
+void stats_init(AssemblyStats *stats)
+{
+	int i;
+
+	for (i = 0; i < NUM_STAGES; i++)
+	{
+		stats->stage_seconds[i] = 0;
+		stats->stage_peak_bytes[i] = 0;
+	}
+
+	stats->files = 0;
+	stats->lines = 0;
+	stats->words = 0;
+	stats->symbols = 0;
+	stats->macros = 0;
+	stats->macro_expansions = 0;
+	stats->fixups = 0;
+	stats->symbol_lookups = 0;
+	stats->cache_hits = 0;
+	
+	for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+		clear_counters(&stats->memory[i]);
+	clear_counters(&stats->memory_total);
+	stats->num_call_sites = 0;
+}
+
+
+
+double stats_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+
+double stats_stage_start(void)
+{
+	MemoryAccount *account = memory_current_account();
+
+	if (account != NULL)
+		account->total.peak_bytes = account->total.live_bytes;
+
+	return stats_clock();
+}
+
+
+
+void stats_stage_end(AssemblyStats *stats, int stage, double start)
+{
+	MemoryAccount *account = memory_current_account();
+
+	stats->stage_seconds[stage] += stats_clock() - start;
+
+	if (account != NULL && account->total.peak_bytes > stats->stage_peak_bytes[stage])
+		stats->stage_peak_bytes[stage] = account->total.peak_bytes;
+}
+
+
+
+void stats_file_start(void)
+{
+	MemoryAccount *account = memory_current_account();
+
+	if (account != NULL)
+		memory_account_reset(account);
+}
+
+
+
+void stats_file_end(AssemblyStats *stats)
+{
+	MemoryAccount *account = memory_current_account();
+	int i;
+
+	if (account == NULL)
+		return;
+
+	for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+		stats->memory[i] = account->subsystems[i];
+	stats->memory_total = account->total;
+
+	for (i = 0; i < account->num_call_sites; i++)
+		stats->call_sites[i] = account->call_sites[i];
+	stats->num_call_sites = account->num_call_sites;
+
+	/* The peak of the total is measured again in every stage, so the peak of the file is the largest of the stages */
+	for (i = 0; i < NUM_STAGES; i++)
+		if (stats->stage_peak_bytes[i] > stats->memory_total.peak_bytes)
+			stats->memory_total.peak_bytes = stats->stage_peak_bytes[i];
+}
+
+
+
+void stats_add(AssemblyStats *total, const AssemblyStats *stats)
+{
+	int i;
+
+	for (i = 0; i < NUM_STAGES; i++)
+	{
+		total->stage_seconds[i] += stats->stage_seconds[i];
+		if (stats->stage_peak_bytes[i] > total->stage_peak_bytes[i])
+			total->stage_peak_bytes[i] = stats->stage_peak_bytes[i];
+	}
+
+	total->files += stats->files;
+	total->lines += stats->lines;
+	total->words += stats->words;
+	total->symbols += stats->symbols;
+	total->macros += stats->macros;
+	total->macro_expansions += stats->macro_expansions;
+	total->fixups += stats->fixups;
+	total->symbol_lookups += stats->symbol_lookups;
+	total->cache_hits += stats->cache_hits;
+	
+	for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+		add_counters(&total->memory[i], &stats->memory[i]);
+	add_counters(&total->memory_total, &stats->memory_total);
+
+	for (i = 0; i < stats->num_call_sites; i++)
+		memory_count_call_site(total->call_sites, &total->num_call_sites, stats->call_sites[i].file, stats->call_sites[i].line, stats->call_sites[i].allocations);
+}
+
+
+
+/* Prints a string as a JSON string, with quotes and escapes */
+static void print_json_string(FILE *stream, const char *str)
+{
+	fputc('"', stream);
+
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			fprintf(stream, "\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			fprintf(stream, "\\u%04x", (unsigned char)*str);
+		else
+			fputc(*str, stream);
+	}
+
+	fputc('"', stream);
+}
+
+
+
+/* Prints the allocations of a call site, in a format for a call site or in one for the other call sites (file NULL) */
+static void print_call_site(FILE *stream, const MemoryCallSite *site, const char *separator, const char *site_format, const char *other_format)
+{
+	fprintf(stream, "%s", separator);
+
+	if (site->file != NULL)
+		fprintf(stream, site_format, site->file, site->line, site->allocations);
+	else
+		fprintf(stream, other_format, site->allocations);
+}
+
+
+
+void stats_print(FILE *stream, const char *name_file, const AssemblyStats *stats, int format)
+{
+	double total_seconds = 0;
+	int i;
+
+	for (i = 0; i < NUM_STAGES; i++)
+		total_seconds += stats->stage_seconds[i];
+
+	if (format == STATS_JSON)
+	{
+		fprintf(stream, "{\"file\": ");
+		if (name_file != NULL)
+			print_json_string(stream, name_file);
+		else
+			fprintf(stream, "null");
+
+		fprintf(stream, ", \"files\": %ld, \"lines\": %ld, \"words\": %ld, \"symbols\": %ld, \"macros\": %ld, \"macro_expansions\": %ld, \"fixups\": %ld, \"symbol_lookups\": %ld, \"cache_hits\": %ld, \"seconds\": {",
+			stats->files, stats->lines, stats->words, stats->symbols, stats->macros, stats->macro_expansions, stats->fixups, stats->symbol_lookups, stats->cache_hits);
+
+		for (i = 0; i < NUM_STAGES; i++)
+			fprintf(stream, "\"%s\": %.6f, ", stage_names[i], stats->stage_seconds[i]);
+
+		fprintf(stream, "\"total\": %.6f}, \"allocations\": %ld, \"peak_bytes\": %ld, \"stage_peak_bytes\": {", total_seconds, stats->memory_total.allocations, stats->memory_total.peak_bytes);
+
+		for (i = 0; i < NUM_STAGES; i++)
+			fprintf(stream, i == 0 ? "\"%s\": %ld" : ", \"%s\": %ld", stage_names[i], stats->stage_peak_bytes[i]);
+
+		fprintf(stream, "}, \"memory\": {");
+		for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+			fprintf(stream, "%s\"%s\": {\"allocations\": %ld, \"peak_bytes\": %ld}", i == 0 ? "" : ", ",
+				memory_subsystem_names[i], stats->memory[i].allocations, stats->memory[i].peak_bytes);
+
+		fprintf(stream, "}, \"call_sites\": {");
+		for (i = 0; i < stats->num_call_sites; i++)
+			print_call_site(stream, &stats->call_sites[i], i == 0 ? "" : ", ", "\"%s:%d\": %ld", "\"other\": %ld");
+
+		fprintf(stream, "}}\n");
+		return;
+	}
+
+	if (name_file != NULL)
+		fprintf(stream, "Statistics of %s:", name_file);
+	else
+		fprintf(stream, "Statistics of all the %ld files:", stats->files);
+
+	fprintf(stream, " %ld lines, %ld words, %ld symbols, %ld macros, %ld macro expansions, %ld fixups, %ld symbol lookups, %ld cache hits\n",
+		stats->lines, stats->words, stats->symbols, stats->macros, stats->macro_expansions, stats->fixups, stats->symbol_lookups, stats->cache_hits);
+
+	fprintf(stream, "\t");
+	for (i = 0; i < NUM_STAGES; i++)
+		fprintf(stream, "%s %.3f ms, ", stage_names[i], stats->stage_seconds[i] * 1000);
+
+	fprintf(stream, "total %.3f ms\n", total_seconds * 1000);
+
+	/* The memory line lists the peak of every stage, and the subsystems that held any memory */
+	fprintf(stream, "\tmemory: %ld allocations, peak %ld bytes; peak bytes by stage:", stats->memory_total.allocations, stats->memory_total.peak_bytes);
+	for (i = 0; i < NUM_STAGES; i++)
+		fprintf(stream, "%s %s %ld", i == 0 ? "" : ",", stage_names[i], stats->stage_peak_bytes[i]);
+
+	fprintf(stream, "; peak bytes (allocations) by subsystem:");
+	for (i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++)
+		if (stats->memory[i].peak_bytes > 0)
+			fprintf(stream, " %s %ld (%ld)", memory_subsystem_names[i], stats->memory[i].peak_bytes, stats->memory[i].allocations);
+	fprintf(stream, "\n");
+
+	if (stats->num_call_sites > 0)
+	{
+		fprintf(stream, "\tallocations by call site:");
+		for (i = 0; i < stats->num_call_sites; i++)
+			print_call_site(stream, &stats->call_sites[i], i == 0 ? " " : ", ", "%s:%d %ld", "other %ld");
+		fprintf(stream, "\n");
+	}
+}
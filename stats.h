@@ -0,0 +1,127 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "memory.h"
+
+
+/* The stages of assembling a file that are timed */
+#define STAGE_MACRO_ANALYZE 0
+#define STAGE_FIRST_PASS_ANALYZE 1
+#define STAGE_MERGE_ENTRY_LABELS 2
+#define STAGE_UPDATE_CODE_WORDS 3
+#define STAGE_CREATE_OBJECT_FILE 4
+#define STAGE_CREATE_OTHER_FILES 5 /* The files with suffixes m (on request), ent and ext */
+#define STAGE_BUILD_CACHE 6 /* Looking up the source in the build cache, and storing its output files there */
+#define NUM_STAGES 7
+
+/* The formats of the statistics (--stats and --stats=json) */
+#define STATS_NONE 0
+#define STATS_TEXT 1
+#define STATS_JSON 2
+
+
+/*
+ * The statistics of assembling a file, or the totals of several files.
+ * The counters are filled as the file is assembled, and cost nothing worth measuring, so they are always kept
+ * and are only printed on request. The memory figures are measured only while the thread has a memory account
+ * (for the totals, the allocations are summed and the peaks are the largest of the files).
+ */
+typedef struct {
+	double stage_seconds[NUM_STAGES]; /* The wall time of each stage */
+	long files;
+	long lines; /* The lines of the source file (with suffix s) */
+	long words; /* The instruction and data words */
+	long symbols;
+	long macros;
+	long macro_expansions; /* The macro calls that were replaced by the content of the macro */
+	long fixups; /* The operands that waited for the address of a label */
+	long symbol_lookups; /* The lookups of names in the symbol table */
+	long cache_hits; /* The files that were restored from the build cache instead of being assembled */
+	long stage_peak_bytes[NUM_STAGES]; /* The most memory that was allocated at one time during each stage */
+	MemoryCounters memory[NUM_MEMORY_SUBSYSTEMS]; /* The allocations of the file by subsystem */
+	MemoryCounters memory_total;
+	MemoryCallSite call_sites[MEMORY_MAX_CALL_SITES]; /* The allocations of the file by call site */
+	int num_call_sites;
+} AssemblyStats;
+
+
+
+/**
+ * Initializes statistics to zero.
+ *
+ * @param stats The statistics to initialize.
+ */
+void stats_init(AssemblyStats *stats);
+
+
+
+/**
+ * Returns the time of a monotonic clock, for measuring the wall time of a stage.
+ *
+ * @return The time in seconds, from an arbitrary starting point.
+ */
+double stats_clock(void);
+
+
+
+/**
+ * Starts a stage: starts measuring its time, and the peak of the memory of the calling thread during it.
+ *
+ * @return The start time of the stage, to pass to stats_stage_end.
+ */
+double stats_stage_start(void);
+
+
+
+/**
+ * Ends a stage, and adds its time and memory peak to the statistics.
+ *
+ * @param stats The statistics of the file.
+ * @param stage The stage (STAGE_...).
+ * @param start The value that stats_stage_start returned.
+ */
+void stats_stage_end(AssemblyStats *stats, int stage, double start);
+
+
+
+/**
+ * Starts counting the allocations of a file in the memory account of the calling thread (if it has one).
+ */
+void stats_file_start(void);
+
+
+
+/**
+ * Copies the allocations of a file from the memory account of the calling thread (if it has one) to its statistics.
+ *
+ * @param stats The statistics of the file.
+ */
+void stats_file_end(AssemblyStats *stats);
+
+
+
+/**
+ * Adds the statistics of a file to the totals.
+ *
+ * @param total The totals.
+ * @param stats The statistics to add.
+ */
+void stats_add(AssemblyStats *total, const AssemblyStats *stats);
+
+
+
+/**
+ * Prints statistics in one of the formats: a line of counters, a line of stage times, a line of memory figures
+ * and a line of the allocations by call site (STATS_TEXT), or a single JSON object on one line (STATS_JSON).
+ *
+ * @param stream The stream to print to.
+ * @param name_file The name of the source file, or NULL for the totals of all the files.
+ * @param stats The statistics to print.
+ * @param format STATS_TEXT or STATS_JSON.
+ */
+void stats_print(FILE *stream, const char *name_file, const AssemblyStats *stats, int format);
+
+
+
+#endif
@@ -0,0 +1,239 @@
+#include "symbol_table.h"
+#include "utils_and_checks.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+/* Returns 1 if the null-terminated name of a symbol is the given name */
+static int name_equals(const char *symbol_name, const char *name, int len)
+{
+	return strncmp(symbol_name, name, len) == 0 && symbol_name[len] == EOS;
+}
+
+
+
+/* Returns the slot of the name, that is the slot that holds it or the empty slot where it should be inserted */
+static int find_slot(SymbolTable *table, const char *name, int len)
+{
+	int mask = table->num_slots - 1;
+	int slot = (int)(hash_span(name, len) & mask);
+
+	/* Linear probing until the name or an empty slot is found */
+	while (table->slots[slot] != 0 && !name_equals(table->symbols[table->slots[slot] - 1].name, name, len))
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+
+
+/* Doubles the number of hash slots and re-inserts all the symbols */
+static void grow_slots(SymbolTable *table)
+{
+	int i;
+
+	memory_free(table->slots);
+	table->num_slots *= 2;
+	table->slots = (int *)memory_calloc(table->num_slots, sizeof(int), MEMORY_SYMBOLS);
+
+	for (i = 0; i < table->count; i++)
+		table->slots[find_slot(table, table->symbols[i].name, (int)strlen(table->symbols[i].name))] = i + 1;
+}
+
+
+
+/* Returns the symbol with the given name, adding an empty (not defined) one if it does not exist yet */
+static SymbolNode *get_or_add_symbol(SymbolTable *table, const char *name, int len, int line_num)
+{
+	SymbolNode *symbol;
+	int slot;
+
+	table->lookups++;
+	if (table->slots == NULL)
+	{
+		table->num_slots = SYMBOL_TABLE_INIT_SLOTS / 2;
+		grow_slots(table);
+	}
+
+	slot = find_slot(table, name, len);
+	if (table->slots[slot] != 0)
+		return &table->symbols[table->slots[slot] - 1];
+
+	/* Keep the load factor of the hash index at most 1/2 */
+	if (2 * (table->count + 1) > table->num_slots)
+	{
+		grow_slots(table);
+		slot = find_slot(table, name, len);
+	}
+
+	if (table->count == table->capacity)
+	{
+		table->capacity = table->capacity ? 2 * table->capacity : SYMBOL_TABLE_INIT_SLOTS / 2;
+		table->symbols = (SymbolNode *)memory_realloc(table->symbols, table->capacity * sizeof(SymbolNode), MEMORY_SYMBOLS);
+		table->defined_order = (int *)memory_realloc(table->defined_order, table->capacity * sizeof(int), MEMORY_SYMBOLS);
+	}
+
+	symbol = &table->symbols[table->count];
+	symbol->name = arena_strndup(table->arena, name, len);
+
+	symbol->adress = 0;
+	symbol->before_data = 0;
+	symbol->is_entry = 0;
+	symbol->is_extern = 0;
+	symbol->is_defined = 0;
+	symbol->line_num = line_num;
+	symbol->entry_line_num = 0;
+	symbol->waiting = 0;
+
+	table->slots[slot] = ++table->count;
+
+	return symbol;
+}
+
+
+
+void symbol_table_init(SymbolTable *table, Arena *arena, Diagnostics *diagnostics)
+{
+	table->symbols = NULL;
+	table->count = 0;
+	table->capacity = 0;
+	table->slots = NULL;
+	table->num_slots = 0;
+	table->defined_order = NULL;
+	table->num_defined = 0;
+	table->lookups = 0;
+	table->arena = arena;
+	table->diagnostics = diagnostics;
+}
+
+
+
+void symbol_table_free(SymbolTable *table)
+{
+	memory_free(table->symbols);
+	memory_free(table->slots);
+	memory_free(table->defined_order);
+
+	symbol_table_init(table, table->arena, table->diagnostics);
+}
+
+
+
+SymbolNode *find_symbol(SymbolTable *table, const char *name, int len)
+{
+	int slot;
+
+	table->lookups++;
+	if (table->slots == NULL)
+		return NULL;
+
+	slot = find_slot(table, name, len);
+	if (table->slots[slot] == 0)
+		return NULL;
+
+	return &table->symbols[table->slots[slot] - 1];
+}
+
+
+
+int reference_symbol(SymbolTable *table, const char *name, int len, int line_num)
+{
+	return (int)(get_or_add_symbol(table, name, len, line_num) - table->symbols);
+}
+
+
+
+int define_symbol(SymbolTable *table, const char *name, int len, int adress, int before_data, int line_num)
+{
+	SymbolNode *symbol = get_or_add_symbol(table, name, len, line_num);
+
+	if (symbol->is_defined)
+	{
+		report(table->diagnostics, "Error in line number %d: Label %.*s is defined for the second time. A label name cannot be defined more than once.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	if (symbol->is_extern)
+	{
+		report(table->diagnostics, "Error in line number %d: An extern label %.*s is defined in the current file.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	symbol->adress = adress;
+	symbol->before_data = before_data;
+	symbol->is_defined = 1;
+	symbol->line_num = line_num;
+	table->defined_order[table->num_defined++] = (int)(symbol - table->symbols);
+
+	return SUCCESS;
+}
+
+
+
+int declare_entry_symbol(SymbolTable *table, const char *name, int len, int line_num)
+{
+	SymbolNode *symbol = get_or_add_symbol(table, name, len, line_num);
+
+	if (symbol->is_extern)
+	{
+		report(table->diagnostics, "Error in line number %d: Label '%.*s' is defined as both entry and extern.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	/* A label cannot be declared as entry more than once */
+	if (symbol->is_entry)
+	{
+		report(table->diagnostics, "Error in line number %d: Label %.*s is defined for the second time. A label name cannot be defined more than once.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	symbol->is_entry = 1;
+	symbol->entry_line_num = line_num;
+
+	return SUCCESS;
+}
+
+
+
+int declare_extern_symbol(SymbolTable *table, const char *name, int len, int line_num)
+{
+	SymbolNode *symbol = get_or_add_symbol(table, name, len, line_num);
+
+	if (symbol->is_defined)
+	{
+		report(table->diagnostics, "Error in line number %d: An extern label %.*s is defined in the current file.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	/* A label cannot be declared as extern more than once, the error is reported on the first declaration */
+	if (symbol->is_extern)
+	{
+		report(table->diagnostics, "Error in line number %d: An extern label %.*s is defined in the current file.\n", symbol->line_num, len, name);
+		return ERROR;
+	}
+
+	symbol->is_extern = 1;
+	symbol->line_num = line_num;
+	table->defined_order[table->num_defined++] = (int)(symbol - table->symbols);
+
+	/* The label is kept as extern only, so that the conflict is not reported again as an undefined entry label,
+	   or as an undefined label where it is used */
+	if (symbol->is_entry)
+	{
+		symbol->is_entry = 0;
+		report(table->diagnostics, "Error in line number %d: Label '%.*s' is defined as both entry and extern.\n", line_num, len, name);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+
+int symbol_address(const SymbolNode *symbol, int data_base)
+{
+	return symbol->before_data ? symbol->adress + data_base : symbol->adress;
+}
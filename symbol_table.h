@@ -0,0 +1,162 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "arena.h"
+#include "diagnostics.h"
+
+#define SYMBOL_TABLE_INIT_SLOTS 64 /* Initial number of hash slots, must be a power of 2 */
+
+
+typedef struct {
+	char *name;
+	int adress;
+	int before_data; /* 1 for a label of a data line, whose address stays relative to the data section */
+	int is_entry;
+	int is_extern;
+	int is_defined; /* 1 once the label itself was defined in the source file (not only mentioned in '.entry') */
+	int line_num; /* Line of the definition, or of the first mention if the label is not defined yet */
+	int entry_line_num; /* Line of the '.entry' directive, (used for error messages). */
+	int waiting; /* With bounded memory: the index + 1 of the last fixup that waits for the label, 0 if none */
+} SymbolNode;
+
+
+/*
+ * The symbol table keeps the symbols in an array by order of first mention, and an open addressing
+ * hash index (linear probing) over that array, keyed on the symbol name.
+ * Each slot holds the index of a symbol + 1, so that 0 marks an empty slot.
+ * In addition, the indexes of the defined and external symbols are kept in the order of their
+ * definition, which is the order the output files are written in.
+ * Names are passed with their length, so that a label can be looked up in place in a line of the source,
+ * and they are copied (null-terminated) into the arena only when a new symbol is added.
+ */
+typedef struct {
+	SymbolNode *symbols;
+	int count;
+	int capacity;
+	int *slots;
+	int num_slots; /* Always a power of 2 */
+	int *defined_order;
+	int num_defined;
+	long lookups; /* The number of lookups of names, (for the statistics) */
+	Arena *arena; /* The symbol names are allocated from this arena */
+	Diagnostics *diagnostics; /* The error messages of the table are reported here */
+} SymbolTable;
+
+
+
+/**
+ * Initializes an empty symbol table.
+ *
+ * @param table The symbol table to initialize.
+ * @param arena The arena that the symbol names are allocated from.
+ * @param diagnostics The buffer that the error messages are reported to.
+ */
+void symbol_table_init(SymbolTable *table, Arena *arena, Diagnostics *diagnostics);
+
+
+
+/**
+ * Frees the memory held by the symbol table (the symbol names are released with the arena).
+ * The table is left empty and can be used again.
+ *
+ * @param table The symbol table to free.
+ */
+void symbol_table_free(SymbolTable *table);
+
+
+
+/**
+ * Looks up a symbol by its name.
+ *
+ * The returned pointer is valid only until the next symbol is added to the table.
+ *
+ * @param table The symbol table.
+ * @param name The name of the symbol.
+ * @param len The length of the name.
+ * @return A pointer to the symbol, or NULL if no symbol with this name was mentioned.
+ */
+SymbolNode *find_symbol(SymbolTable *table, const char *name, int len);
+
+
+
+/**
+ * Returns the index of a label in the table, for a reference to it from an operand.
+ * A label that was not mentioned yet is added, not defined, so that it can be defined later in the source file.
+ *
+ * Unlike a pointer to the symbol, the index stays valid when more symbols are added to the table.
+ *
+ * @param table The symbol table.
+ * @param name The name of the label.
+ * @param len The length of the name.
+ * @param line_num The line of the reference.
+ * @return The index of the symbol in the array of the symbols.
+ */
+int reference_symbol(SymbolTable *table, const char *name, int len, int line_num);
+
+
+
+/**
+ * Defines a label at the given address.
+ *
+ * A label that was already defined in the source file, or that was declared as `extern`,
+ * cannot be defined again. In these cases an error message is reported.
+ *
+ * @param table The symbol table.
+ * @param name The name of the label.
+ * @param len The length of the name.
+ * @param adress The address of the label (IC for instructions, DC for data).
+ * @param before_data 1 if the label is defined on a data line (its address is relative to the data section), 0 otherwise.
+ * @param line_num The line of the definition, (used for error messages).
+ * @return SUCCESS if the label was defined, ERROR otherwise.
+ */
+int define_symbol(SymbolTable *table, const char *name, int len, int adress, int before_data, int line_num);
+
+
+
+/**
+ * Marks a label as `entry`. The label itself may be defined before or after the directive.
+ *
+ * A label that was declared as `extern` cannot also be an entry label, and a label cannot be marked twice.
+ * In these cases an error message is reported.
+ *
+ * @param table The symbol table.
+ * @param name The name of the label.
+ * @param len The length of the name.
+ * @param line_num The line of the '.entry' directive, (used for error messages).
+ * @return SUCCESS if the label was marked, ERROR otherwise.
+ */
+int declare_entry_symbol(SymbolTable *table, const char *name, int len, int line_num);
+
+
+
+/**
+ * Declares a label as `extern`.
+ *
+ * A label that is defined in the current source file, or that is marked as `entry`,
+ * cannot be external, and a label cannot be declared as `extern` twice. In these cases an error message is reported.
+ * A label that was marked as `entry` is still declared (and is no longer an entry label), so that the conflict
+ * is the only error that is reported about it.
+ *
+ * @param table The symbol table.
+ * @param name The name of the label.
+ * @param len The length of the name.
+ * @param line_num The line of the '.extern' directive, (used for error messages).
+ * @return SUCCESS if the label was declared, ERROR otherwise.
+ */
+int declare_extern_symbol(SymbolTable *table, const char *name, int len, int line_num);
+
+
+
+/**
+ * Returns the final address of a label.
+ * The address of a label of a data line is relative to the data section, so the start of the data section is added to it.
+ *
+ * @param symbol The label.
+ * @param data_base The address the data section starts at, (the final IC).
+ * @return The address of the label.
+ */
+int symbol_address(const SymbolNode *symbol, int data_base);
+
+
+
+#endif
@@ -0,0 +1,65 @@
+#include "text_buffer.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+void text_buffer_init(TextBuffer *buffer)
+{
+	buffer->text = NULL;
+	buffer->length = 0;
+	buffer->capacity = 0;
+}
+
+
+
+void text_buffer_reserve(TextBuffer *buffer, int len)
+{
+	int capacity;
+	
+	if (buffer->length + len + 1 <= buffer->capacity)
+		return;
+	
+	capacity = buffer->capacity ? buffer->capacity : TEXT_BUFFER_INIT_CAPACITY;
+	while (buffer->length + len + 1 > capacity)
+		capacity *= 2;
+	
+	buffer->text = (char *)memory_realloc(buffer->text, capacity, MEMORY_TEXT);
+	buffer->capacity = capacity;
+}
+
+
+
+void text_buffer_append(TextBuffer *buffer, const char *str, int len)
+{
+	text_buffer_reserve(buffer, len);
+	
+	memcpy(buffer->text + buffer->length, str, len);
+	buffer->length += len;
+	buffer->text[buffer->length] = '\0';
+}
+
+
+
+char *text_buffer_extend(TextBuffer *buffer, int len)
+{
+	char *dest;
+	
+	text_buffer_reserve(buffer, len);
+	
+	dest = buffer->text + buffer->length;
+	buffer->length += len;
+	buffer->text[buffer->length] = '\0';
+	
+	return dest;
+}
+
+
+
+void text_buffer_free(TextBuffer *buffer)
+{
+	memory_free(buffer->text);
+	text_buffer_init(buffer);
+}
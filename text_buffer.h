@@ -0,0 +1,69 @@
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+
+#define TEXT_BUFFER_INIT_CAPACITY 4096 /* Initial size of a text buffer */
+
+
+/* A growable, null-terminated string that keeps its length, so that appending to it does not rescan it */
+typedef struct {
+	char *text;
+	int length;
+	int capacity;
+} TextBuffer;
+
+
+
+/**
+ * Initializes an empty text buffer.
+ *
+ * @param buffer The buffer to initialize.
+ */
+void text_buffer_init(TextBuffer *buffer);
+
+
+
+/**
+ * Grows the buffer, if needed, so that `len` more characters fit in it without another allocation.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param buffer The buffer to grow.
+ * @param len The number of characters that are going to be appended.
+ */
+void text_buffer_reserve(TextBuffer *buffer, int len);
+
+
+
+/**
+ * Appends characters to the end of the buffer, growing it if needed.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param buffer The buffer to append to.
+ * @param str The characters to append.
+ * @param len The number of characters to append.
+ */
+void text_buffer_append(TextBuffer *buffer, const char *str, int len);
+
+
+
+/**
+ * Appends `len` characters to the end of the buffer, for the caller to fill in place, growing the buffer if needed.
+ *
+ * @param buffer The buffer to append to.
+ * @param len The number of characters to append.
+ * @return A pointer to the first of the appended characters, valid until the buffer is changed again.
+ */
+char *text_buffer_extend(TextBuffer *buffer, int len);
+
+
+
+/**
+ * Frees the memory held by the buffer.
+ *
+ * @param buffer The buffer to free.
+ */
+void text_buffer_free(TextBuffer *buffer);
+
+
+
+#endif
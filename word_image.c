@@ -0,0 +1,36 @@
+#include "word_image.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+void word_image_init(WordImage *image)
+{
+	image->words = NULL;
+	image->count = 0;
+	image->capacity = 0;
+}
+
+
+
+int word_image_append(WordImage *image, uint16_t word)
+{
+	
+	if (image->count == image->capacity)
+	{
+		image->capacity = image->capacity ? 2 * image->capacity : WORD_IMAGE_INIT_CAPACITY;
+		image->words = (uint16_t *)memory_realloc(image->words, image->capacity * sizeof(uint16_t), MEMORY_CODE);
+	}
+	
+	image->words[image->count] = word;
+	return image->count++;
+}
+
+
+
+void word_image_free(WordImage *image)
+{
+	memory_free(image->words);
+	word_image_init(image);
+}
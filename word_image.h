@@ -0,0 +1,52 @@
+#ifndef WORD_IMAGE_H
+#define WORD_IMAGE_H
+
+#include <stdint.h>
+
+
+#define WORD_IMAGE_INIT_CAPACITY 256 /* Initial number of words of an image */
+
+
+/* 
+ * A section of the machine code (the instructions or the data), as a growable array of 15-bit words.
+ * The word at index i is at address base + i, where the base of the section is applied only when the words are written out.
+ */
+typedef struct {
+	uint16_t *words;
+	int count;
+	int capacity;
+} WordImage;
+
+
+
+/**
+ * Initializes an empty image.
+ *
+ * @param image The image to initialize.
+ */
+void word_image_init(WordImage *image);
+
+
+
+/**
+ * Appends a word to the end of the image, growing it if needed.
+ * If memory allocation fails, the function prints an error message and exits the program.
+ *
+ * @param image The image.
+ * @param word The word to append.
+ * @return The index of the word in the image.
+ */
+int word_image_append(WordImage *image, uint16_t word);
+
+
+
+/**
+ * Frees the memory held by the image.
+ *
+ * @param image The image to free.
+ */
+void word_image_free(WordImage *image);
+
+
+
+#endif